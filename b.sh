@@ -10,3 +10,4 @@ mkdir -p ~/.local/sonic/lib
 clear
 
 sonic compile examples
+sonic compile examples -j4
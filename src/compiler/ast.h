@@ -117,6 +117,8 @@ namespace sonic::frontend::ast {
 
     // decoration
     bool nullable_  = false;
+    // `T* restrict` / `T& restrict`: the only pointer to its memory
+    bool restrict_  = false;
 
     // semantic info
     void* symbols_ = nullptr;
@@ -136,6 +138,7 @@ namespace sonic::frontend::ast {
       for (auto& ch : generics_) type->generics_.push_back(ch->clone());
 
       type->nullable_ = nullable_;
+      type->restrict_ = restrict_;
 
       return type;
     }
@@ -221,8 +224,11 @@ namespace sonic::frontend::ast {
     std::unique_ptr<Expression> clone() {
       auto expr = std::make_unique<Expression>();
       expr->kind_ = kind_;
+      expr->literal_ = literal_;
       expr->loc_ = loc_;
       expr->name_ = name_;
+      expr->value_ = value_;
+      expr->raw_ = raw_;
 
       for (auto& ch : generics_) expr->generics_.push_back(ch->clone());
       for (auto& ch : args_) expr->args_.push_back(ch->clone());
@@ -286,6 +292,13 @@ namespace sonic::frontend::ast {
     }
   };
 
+  // body that is still encoded in a cache file, see ast_binary.h
+  struct LazyBody {
+    virtual ~LazyBody() = default;
+    // false if the encoded body is damaged
+    virtual bool load(Statement& owner) = 0;
+  };
+
   // MARK: STATEMENT
   struct Statement {
     StmtKind kind_;
@@ -314,6 +327,10 @@ namespace sonic::frontend::ast {
     // function | macro attr
     std::vector<std::unique_ptr<Statement>> params_;
 
+    // `@name(args)` in front of a declaration, each a MACRO_ATTR whose
+    // params_ hold the arguments by name_
+    std::vector<std::unique_ptr<Statement>> attributes_;
+
     // function | while | for
     std::vector<std::unique_ptr<Statement>> body_;
 
@@ -339,10 +356,34 @@ namespace sonic::frontend::ast {
     // semantic info
     void* symbols_ = nullptr;
 
+    // set when body_ has not been decoded yet
+    std::shared_ptr<LazyBody> lazy_body_;
+
     Statement() = default;
     ~Statement() = default;
 
+    // decode body_ on first use; a no-op for parsed statements. False,
+    // with body_ left empty, when the cached encoding cannot be read
+    bool materialize() {
+      if (!lazy_body_) return true;
+      auto body = std::move(lazy_body_);
+      if (body->load(*this)) return true;
+      body_.clear();
+      return false;
+    }
+
+    // this statement or one nested in it still has an encoded body
+    bool hasLazyBody() const {
+      if (lazy_body_) return true;
+      for (auto& ch : body_) {
+        if (ch->hasLazyBody()) return true;
+      }
+      return false;
+    }
+
     std::unique_ptr<Statement> clone() {
+      materialize();
+
       auto stmt = std::make_unique<Statement>();
       stmt->kind_ = kind_;
       stmt->loc_ = loc_;
@@ -364,6 +405,7 @@ namespace sonic::frontend::ast {
       for (auto& ch : import_items_) stmt->import_items_.push_back(ch->clone());
       for (auto& ch : generics_) stmt->generics_.push_back(ch->clone());
       for (auto& ch : params_) stmt->params_.push_back(ch->clone());
+      for (auto& ch : attributes_) stmt->attributes_.push_back(ch->clone());
       for (auto& ch : body_) stmt->body_.push_back(ch->clone());
 
       for (auto& ch : then_) stmt->then_.push_back(ch->clone());
@@ -376,11 +418,22 @@ namespace sonic::frontend::ast {
   struct Program {
     std::string name_;
 
+    // loaded from the build cache instead of parsed
+    bool cached_ = false;
+
     std::vector<std::unique_ptr<Statement>> statements_;
 
     Program() = default;
     ~Program() = default;
 
+    // true while a function body read from the cache is still encoded
+    bool hasLazyBodies() const {
+      for (auto& st : statements_) {
+        if (st->hasLazyBody()) return true;
+      }
+      return false;
+    }
+
     Program(const Program&) = delete;
     Program& operator=(const Program&) = delete;
 
@@ -0,0 +1,429 @@
+// ast_binary.cpp
+
+// c++ library
+#include <cstring>
+
+// local headers
+#include "ast_binary.h"
+
+namespace sonic::frontend::ast::binary {
+
+  // MARK: ENCODER
+  void Encoder::writeVarint(uint64_t v) {
+    while (v >= 0x80) {
+      out_.push_back(static_cast<char>((v & 0x7f) | 0x80));
+      v >>= 7;
+    }
+    out_.push_back(static_cast<char>(v));
+  }
+
+  void Encoder::writeU32At(size_t pos, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+      out_[pos + i] = static_cast<char>((v >> (i * 8)) & 0xff);
+    }
+  }
+
+  void Encoder::writeString(const std::string& s) {
+    auto it = string_ids_.find(s);
+    if (it != string_ids_.end()) {
+      writeVarint(it->second);
+      return;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings_.size());
+    strings_.push_back(s);
+    string_ids_.emplace(strings_.back(), id);
+    writeVarint(id);
+  }
+
+  void Encoder::writeLoc(const SourceLocation& loc) {
+    // path and source line are interned, so every node on the same line
+    // shares one copy of the text
+    writeString(loc.path);
+    writeString(loc.lines);
+    writeString(loc.raw_value);
+
+    writeVarint(loc.line);
+    writeVarint(loc.column);
+    writeVarint(loc.offset);
+    writeVarint(loc.start);
+    writeVarint(loc.end);
+  }
+
+  void Encoder::writeType(const Type& t) {
+    writeVarint(static_cast<uint32_t>(t.kind_));
+    writeVarint(static_cast<uint32_t>(t.literal_));
+    writeString(t.name_);
+    writeVarint(t.nullable_);
+    writeVarint(t.restrict_);
+    writeLoc(t.loc_);
+
+    writeVarint(t.nested_ ? 1 : 0);
+    if (t.nested_) writeType(*t.nested_);
+
+    writeVarint(t.generics_.size());
+    for (auto& g : t.generics_) writeType(*g);
+  }
+
+  void Encoder::writeExpr(const Expression& e) {
+    writeVarint(static_cast<uint32_t>(e.kind_));
+    writeVarint(static_cast<uint32_t>(e.literal_));
+    writeString(e.name_);
+    writeString(e.value_);
+    writeString(e.raw_);
+    writeLoc(e.loc_);
+
+    writeVarint(e.generics_.size());
+    for (auto& g : e.generics_) writeType(*g);
+
+    writeVarint(e.args_.size());
+    for (auto& a : e.args_) writeExpr(*a);
+
+    uint32_t mask = (e.nested_ ? 1u : 0u)
+                  | (e.index_  ? 2u : 0u)
+                  | (e.callee_ ? 4u : 0u)
+                  | (e.lhs_    ? 8u : 0u)
+                  | (e.rhs_    ? 16u : 0u);
+    writeVarint(mask);
+
+    if (e.nested_) writeExpr(*e.nested_);
+    if (e.index_)  writeExpr(*e.index_);
+    if (e.callee_) writeExpr(*e.callee_);
+    if (e.lhs_)    writeExpr(*e.lhs_);
+    if (e.rhs_)    writeExpr(*e.rhs_);
+  }
+
+  void Encoder::writeStmt(const Statement& s) {
+    writeVarint(static_cast<uint32_t>(s.kind_));
+
+    uint32_t flags = (s.public_     ? 1u : 0u)
+                   | (s.extern_     ? 2u : 0u)
+                   | (s.async_      ? 4u : 0u)
+                   | (s.import_all_ ? 8u : 0u)
+                   | (s.declare_    ? 16u : 0u)
+                   | (s.variadic_   ? 32u : 0u);
+    writeVarint(flags);
+    writeVarint(static_cast<uint32_t>(s.mutability));
+
+    writeString(s.name_);
+    writeString(s.import_alias_);
+    writeLoc(s.loc_);
+
+    uint32_t mask = (s.assign_ ? 1u : 0u)
+                  | (s.value_  ? 2u : 0u)
+                  | (s.type_   ? 4u : 0u);
+    writeVarint(mask);
+
+    if (s.assign_) writeExpr(*s.assign_);
+    if (s.value_)  writeExpr(*s.value_);
+    if (s.type_)   writeType(*s.type_);
+
+    writeStmts(s.import_qualified_);
+    writeStmts(s.import_items_);
+    writeStmts(s.generics_);
+    writeStmts(s.params_);
+    writeStmts(s.attributes_);
+    writeBlock(s.body_);
+    writeStmts(s.then_);
+    writeStmts(s.else_);
+    writeStmts(s.try_);
+    writeStmts(s.catch_);
+    writeStmts(s.finally_);
+  }
+
+  void Encoder::writeStmts(const std::vector<std::unique_ptr<Statement>>& v) {
+    writeVarint(v.size());
+    for (auto& s : v) writeStmt(*s);
+  }
+
+  void Encoder::writeBlock(const std::vector<std::unique_ptr<Statement>>& v) {
+    writeVarint(v.size());
+
+    // reserve the byte size, patched once the block is written
+    size_t sizePos = out_.size();
+    out_.append(4, '\0');
+
+    size_t start = out_.size();
+    for (auto& s : v) writeStmt(*s);
+    writeU32At(sizePos, static_cast<uint32_t>(out_.size() - start));
+  }
+
+  void Encoder::writeProgram(const Program& p) {
+    out_.assign(HEADER_SIZE, '\0');
+
+    writeString(p.name_);
+    writeVarint(p.statements_.size());
+    for (auto& s : p.statements_) writeStmt(*s);
+  }
+
+  std::string Encoder::finish() {
+    size_t stringsPos = out_.size();
+
+    writeVarint(strings_.size());
+    for (auto& s : strings_) {
+      writeVarint(s.size());
+      out_.append(s.data(), s.size());
+    }
+
+    std::memcpy(out_.data(), MAGIC, 4);
+    out_[4] = static_cast<char>(FORMAT_VERSION & 0xff);
+    out_[5] = static_cast<char>(FORMAT_VERSION >> 8);
+    writeU32At(8, static_cast<uint32_t>(HEADER_SIZE));
+    writeU32At(12, static_cast<uint32_t>(stringsPos));
+
+    return std::move(out_);
+  }
+
+  // MARK: DECODER
+  static size_t varintSize(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+      v >>= 7;
+      n++;
+    }
+    return n;
+  }
+
+  struct BinaryBody : LazyBody {
+    std::shared_ptr<const Image> image;
+    size_t pos;
+
+    BinaryBody(std::shared_ptr<const Image> image, size_t pos) : image(std::move(image)), pos(pos) {}
+
+    bool load(Statement& owner) override {
+      Decoder dec(image, pos);
+      dec.readBlock(owner);
+      return dec.valid();
+    }
+  };
+
+  Decoder::Decoder(const uint8_t* data, size_t size, std::shared_ptr<const void> owner) : data_(data), size_(size) {
+    if (!data_ || size_ < HEADER_SIZE || std::memcmp(data_, MAGIC, 4) != 0) {
+      failed_ = true;
+      return;
+    }
+
+    uint16_t version = data_[4] | (data_[5] << 8);
+    if (version != FORMAT_VERSION) {
+      failed_ = true;
+      return;
+    }
+
+    auto image = std::make_shared<Image>();
+    image->owner = std::move(owner);
+    image->data = data_;
+    image->size = size_;
+
+    pos_ = 8;
+    image->nodes = readU32();
+    size_t stringsPos = readU32();
+    if (stringsPos > size_ || image->nodes > size_) {
+      failed_ = true;
+      return;
+    }
+
+    pos_ = stringsPos;
+    uint64_t count = readVarint();
+    image->strings.reserve(failed_ ? 0 : count);
+    for (uint64_t i = 0; i < count && !failed_; i++) {
+      uint64_t len = readVarint();
+      if (len > size_ - pos_) {
+        failed_ = true;
+        break;
+      }
+      image->strings.emplace_back(reinterpret_cast<const char*>(data_ + pos_), len);
+      pos_ += len;
+    }
+
+    pos_ = image->nodes;
+    image_ = std::move(image);
+  }
+
+  Decoder::Decoder(std::shared_ptr<const Image> image, size_t pos)
+  : image_(std::move(image)), data_(image_->data), size_(image_->size), pos_(pos)
+  {}
+
+  uint64_t Decoder::readVarint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos_ >= size_) {
+        failed_ = true;
+        return 0;
+      }
+      uint8_t b = data_[pos_++];
+      v |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    failed_ = true;
+    return 0;
+  }
+
+  uint32_t Decoder::readU32() {
+    if (size_ - pos_ < 4 || pos_ > size_) {
+      failed_ = true;
+      return 0;
+    }
+    uint32_t v = data_[pos_] | (data_[pos_ + 1] << 8) | (data_[pos_ + 2] << 16) | (static_cast<uint32_t>(data_[pos_ + 3]) << 24);
+    pos_ += 4;
+    return v;
+  }
+
+  std::string Decoder::readString() {
+    uint64_t id = readVarint();
+    if (!image_ || id >= image_->strings.size()) {
+      failed_ = true;
+      return "";
+    }
+    return std::string(image_->strings[id]);
+  }
+
+  SourceLocation Decoder::readLoc() {
+    SourceLocation loc;
+    loc.path      = readString();
+    loc.lines     = readString();
+    loc.raw_value = readString();
+
+    loc.line   = readVarint();
+    loc.column = readVarint();
+    loc.offset = readVarint();
+    loc.start  = readVarint();
+    loc.end    = readVarint();
+    return loc;
+  }
+
+  std::unique_ptr<Type> Decoder::readType() {
+    auto t = std::make_unique<Type>();
+    t->kind_ = static_cast<TypeKind>(readVarint());
+    t->literal_ = static_cast<LiteralKind>(readVarint());
+    t->name_ = readString();
+    t->nullable_ = readVarint() != 0;
+    t->restrict_ = readVarint() != 0;
+    t->loc_ = readLoc();
+
+    if (readVarint() && !failed_) t->nested_ = readType();
+
+    uint64_t count = readVarint();
+    for (uint64_t i = 0; i < count && !failed_; i++)
+      t->generics_.push_back(readType());
+
+    return t;
+  }
+
+  std::unique_ptr<Expression> Decoder::readExpr() {
+    auto e = std::make_unique<Expression>();
+    e->kind_ = static_cast<ExprKind>(readVarint());
+    e->literal_ = static_cast<LiteralKind>(readVarint());
+    e->name_ = readString();
+    e->value_ = readString();
+    e->raw_ = readString();
+    e->loc_ = readLoc();
+
+    uint64_t count = readVarint();
+    for (uint64_t i = 0; i < count && !failed_; i++)
+      e->generics_.push_back(readType());
+
+    count = readVarint();
+    for (uint64_t i = 0; i < count && !failed_; i++)
+      e->args_.push_back(readExpr());
+
+    uint64_t mask = readVarint();
+    if (failed_) return e;
+
+    if (mask & 1)  e->nested_ = readExpr();
+    if (mask & 2)  e->index_  = readExpr();
+    if (mask & 4)  e->callee_ = readExpr();
+    if (mask & 8)  e->lhs_    = readExpr();
+    if (mask & 16) e->rhs_    = readExpr();
+
+    return e;
+  }
+
+  std::unique_ptr<Statement> Decoder::readStmt() {
+    auto s = std::make_unique<Statement>();
+    s->kind_ = static_cast<StmtKind>(readVarint());
+
+    uint64_t flags = readVarint();
+    s->public_     = flags & 1;
+    s->extern_     = flags & 2;
+    s->async_      = flags & 4;
+    s->import_all_ = flags & 8;
+    s->declare_    = flags & 16;
+    s->variadic_   = flags & 32;
+    s->mutability  = static_cast<Mutability>(readVarint());
+
+    s->name_ = readString();
+    s->import_alias_ = readString();
+    s->loc_ = readLoc();
+
+    uint64_t mask = readVarint();
+    if (failed_) return s;
+
+    if (mask & 1) s->assign_ = readExpr();
+    if (mask & 2) s->value_  = readExpr();
+    if (mask & 4) s->type_   = readType();
+
+    readStmts(s->import_qualified_);
+    readStmts(s->import_items_);
+    readStmts(s->generics_);
+    readStmts(s->params_);
+    readStmts(s->attributes_);
+    readBlock(*s);
+    readStmts(s->then_);
+    readStmts(s->else_);
+    readStmts(s->try_);
+    readStmts(s->catch_);
+    readStmts(s->finally_);
+
+    return s;
+  }
+
+  void Decoder::readStmts(std::vector<std::unique_ptr<Statement>>& v) {
+    uint64_t count = readVarint();
+    for (uint64_t i = 0; i < count && !failed_; i++)
+      v.push_back(readStmt());
+  }
+
+  void Decoder::readBlock(Statement& owner) {
+    uint64_t count = readVarint();
+    uint32_t size = readU32();
+    if (failed_) return;
+
+    if (lazy_ && owner.kind_ == StmtKind::FUNCTION && count > 0) {
+      if (size > size_ - pos_) {
+        failed_ = true;
+        return;
+      }
+      owner.lazy_body_ = std::make_shared<BinaryBody>(image_, pos_ - 4 - varintSize(count));
+      pos_ += size;
+      return;
+    }
+
+    for (uint64_t i = 0; i < count && !failed_; i++)
+      owner.body_.push_back(readStmt());
+  }
+
+  Program Decoder::readProgram() {
+    Program p;
+    if (failed_) return p;
+
+    p.name_ = readString();
+    uint64_t count = readVarint();
+    for (uint64_t i = 0; i < count && !failed_; i++)
+      p.statements_.push_back(readStmt());
+
+    return p;
+  }
+
+  std::string serializeProgram(const Program& p) {
+    Encoder enc;
+    enc.writeProgram(p);
+    return enc.finish();
+  }
+
+  Program deserializeProgram(const uint8_t* data, size_t size, bool* ok) {
+    Decoder dec(data, size);
+    Program p = dec.readProgram();
+    if (ok) *ok = dec.valid();
+    return p;
+  }
+}
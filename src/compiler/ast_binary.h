@@ -0,0 +1,99 @@
+#pragma once
+
+// c++ library
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// local headers
+#include "ast.h"
+
+// Binary AST cache format (.ast)
+//
+//   header   : magic "SNAB", u16 version, u16 reserved,
+//              u32 node section offset, u32 string table offset
+//   nodes    : the program encoded in pre-order, every scalar as LEB128 varint,
+//              every string as an index into the string table
+//   strings  : varint count, then (varint length, bytes) per string
+//
+// Statement bodies are written as blocks (varint count, u32 byte size) so a
+// reader can step over them and decode them later (see Decoder::setLazy).
+namespace sonic::frontend::ast::binary {
+
+  constexpr uint8_t  MAGIC[4]       = {'S', 'N', 'A', 'B'};
+  constexpr uint16_t FORMAT_VERSION = 3;
+  constexpr size_t   HEADER_SIZE    = 16;
+
+  class Encoder {
+    public:
+    void writeProgram(const Program& p);
+
+    // header + nodes + string table, ready to be written to disk
+    std::string finish();
+
+    private:
+    std::string out_;
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, uint32_t> string_ids_;
+
+    void writeVarint(uint64_t v);
+    void writeU32At(size_t pos, uint32_t v);
+    void writeString(const std::string& s);
+    void writeLoc(const SourceLocation& loc);
+    void writeType(const Type& t);
+    void writeExpr(const Expression& e);
+    void writeStmt(const Statement& s);
+    void writeStmts(const std::vector<std::unique_ptr<Statement>>& v);
+    void writeBlock(const std::vector<std::unique_ptr<Statement>>& v);
+  };
+
+  // a decoded header and string table over bytes kept alive by `owner`
+  struct Image {
+    std::shared_ptr<const void> owner;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t nodes = 0;
+    std::vector<std::string_view> strings;
+  };
+
+  class Decoder {
+    public:
+    Decoder(const uint8_t* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+    Decoder(std::shared_ptr<const Image> image, size_t pos);
+
+    // false when the header or string table is malformed
+    bool valid() const { return !failed_; }
+
+    // leave function bodies encoded until Statement::materialize(); the
+    // decoded program then keeps the image (and `owner`) alive
+    void setLazy(bool lazy) { lazy_ = lazy; }
+
+    Program readProgram();
+
+    private:
+    std::shared_ptr<const Image> image_;
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool failed_ = false;
+    bool lazy_ = false;
+
+    uint64_t readVarint();
+    uint32_t readU32();
+    std::string readString();
+    SourceLocation readLoc();
+    std::unique_ptr<Type> readType();
+    std::unique_ptr<Expression> readExpr();
+    std::unique_ptr<Statement> readStmt();
+    void readStmts(std::vector<std::unique_ptr<Statement>>& v);
+    void readBlock(Statement& owner);
+
+    friend struct BinaryBody;
+  };
+
+  std::string serializeProgram(const Program& p);
+  Program deserializeProgram(const uint8_t* data, size_t size, bool* ok = nullptr);
+}
@@ -1,7 +1,9 @@
 // ast_io.cpp
 #include "ast_io.h"
+#include "ast_binary.h"
 #include "ast_json.h"
-#include <fstream>
+#include "io.h"
+#include "../core/config.h"
 
 using namespace sonic::frontend::ast::json;
 
@@ -9,17 +11,35 @@ namespace sonic::frontend::ast::io {
   using json = nlohmann::json;
 
   bool saveProgramToFile(const Program& program, const std::string& path) {
-    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    return sonic::io::write_file_atomic(path, binary::serializeProgram(program));
+  }
+
+  std::unique_ptr<Program> loadProgramFromFile(const std::string& path, bool lazy) {
+    auto file = sonic::io::MappedFile::open(path);
+    if (!file) return nullptr;
+
+    binary::Decoder dec(file->data(), file->size(), file);
+    dec.setLazy(lazy);
+
+    auto program = std::make_unique<Program>(dec.readProgram());
+    if (!dec.valid()) return nullptr;
+
+    program->cached_ = true;
+    return program;
+  }
+
+  std::string cachePath(const std::string& moduleName) {
+    return sonic::io::getFullPath(sonic::config::project_build + "/cache/" + sonic::io::getFileNameWithoutExt(moduleName));
+  }
+
+  bool saveProgramToJson(const Program& program, const std::string& path, bool compact) {
+    sonic::io::JsonWriter out(path, !compact);
     if (!out.is_open())
       return false;
 
-    json j = serializeProgram(program);
-
-    // pretty print (buat debug)
-    out << j.dump(2);
+    serializeProgram(program, out);
 
-    out.close();
-    return true;
+    return out.close();
   }
 
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include "ast.h"
 #include <nlohmann/json.hpp>
@@ -8,6 +9,17 @@ using namespace sonic::frontend::ast;
 
 namespace sonic::frontend::ast::io {
 
+// binary cache (.ast), see ast_binary.h
 bool saveProgramToFile(const Program& program, const std::string& path);
+// with `lazy`, function bodies stay in the mapped file until
+// Statement::materialize() is called on them
+std::unique_ptr<Program> loadProgramFromFile(const std::string& path, bool lazy = false);
+
+// build/cache/<module>, without extension, where analysis writes the
+// module's .ast
+std::string cachePath(const std::string& moduleName);
+
+// human readable dump for tooling / --debug
+bool saveProgramToJson(const Program& program, const std::string& path, bool compact = false);
 
 }
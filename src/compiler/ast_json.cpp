@@ -45,6 +45,7 @@ namespace sonic::frontend::ast::json {
     j["literal"] = to_int(t.literal_);
     j["name"] = t.name_;
     j["nullable"] = t.nullable_;
+    j["restrict"] = t.restrict_;
     j["loc"] = serializeLoc(t.loc_);
 
     if (t.nested_)
@@ -63,6 +64,7 @@ namespace sonic::frontend::ast::json {
     t->literal_ = from_int<LiteralKind>(j.at("literal").get<int>());
     t->name_ = j.value("name", "");
     t->nullable_ = j.value("nullable", false);
+    t->restrict_ = j.value("restrict", false);
     t->loc_ = deserializeLoc(j.at("loc"));
 
     if (j.contains("nested"))
@@ -127,6 +129,8 @@ namespace sonic::frontend::ast::json {
 
 
   json serializeStmt(const Statement& s) {
+    auto stmt = [](const Statement& c) { return serializeStmt(c); };
+
     json j;
     j["kind"] = to_int(s.kind_);
     j["name"] = s.name_;
@@ -145,17 +149,18 @@ namespace sonic::frontend::ast::json {
     if (s.value_)  j["value"]  = serializeExpr(*s.value_);
     if (s.type_)   j["type"]   = serializeType(*s.type_);
 
-    j["import_qualified"] = arr_ptr(s.import_qualified_, serializeStmt);
-    j["import_items"] = arr_ptr(s.import_items_, serializeStmt);
+    j["import_qualified"] = arr_ptr(s.import_qualified_, stmt);
+    j["import_items"] = arr_ptr(s.import_items_, stmt);
 
-    j["generics"] = arr_ptr(s.generics_, serializeStmt);
-    j["params"] = arr_ptr(s.params_, serializeStmt);
-    j["body"] = arr_ptr(s.body_, serializeStmt);
-    j["then"] = arr_ptr(s.then_, serializeStmt);
-    j["else"] = arr_ptr(s.else_, serializeStmt);
-    j["try"] = arr_ptr(s.try_, serializeStmt);
-    j["catch"] = arr_ptr(s.catch_, serializeStmt);
-    j["finally"] = arr_ptr(s.finally_, serializeStmt);
+    j["generics"] = arr_ptr(s.generics_, stmt);
+    j["params"] = arr_ptr(s.params_, stmt);
+    j["attributes"] = arr_ptr(s.attributes_, stmt);
+    j["body"] = arr_ptr(s.body_, stmt);
+    j["then"] = arr_ptr(s.then_, stmt);
+    j["else"] = arr_ptr(s.else_, stmt);
+    j["try"] = arr_ptr(s.try_, stmt);
+    j["catch"] = arr_ptr(s.catch_, stmt);
+    j["finally"] = arr_ptr(s.finally_, stmt);
 
     return j;
   }
@@ -189,6 +194,7 @@ namespace sonic::frontend::ast::json {
     load(s->import_items_, "import_items");
     load(s->import_qualified_, "import_qualified");
     load(s->params_, "params");
+    load(s->attributes_, "attributes");
     load(s->body_, "body");
     load(s->then_, "then");
     load(s->else_, "else");
@@ -215,4 +221,119 @@ namespace sonic::frontend::ast::json {
       p.statements_.push_back(deserializeStmt(s));
     return p;
   }
+  // MARK: STREAMING
+  using sonic::io::JsonWriter;
+
+  template<typename T, typename Fn>
+  static void arr_ptr(JsonWriter& w, const char* key, const std::vector<std::unique_ptr<T>>& v, Fn fn) {
+    w.key(key);
+    w.beginArray();
+    for (const auto& x : v) fn(*x, w);
+    w.endArray();
+  }
+
+  void serializeLoc(const SourceLocation& loc, JsonWriter& w) {
+    w.beginObject();
+    w.field("path", loc.path);
+    w.field("lines", loc.lines);
+    w.field("raw", loc.raw_value);
+
+    w.field("line", loc.line);
+    w.field("column", loc.column);
+    w.field("offset", loc.offset);
+    w.field("start", loc.start);
+    w.field("end", loc.end);
+    w.endObject();
+  }
+
+  void serializeType(const Type& t, JsonWriter& w) {
+    w.beginObject();
+    w.field("kind", to_int(t.kind_));
+    w.field("literal", to_int(t.literal_));
+    w.field("name", t.name_);
+    w.field("nullable", t.nullable_);
+    w.field("restrict", t.restrict_);
+    w.key("loc");
+    serializeLoc(t.loc_, w);
+
+    if (t.nested_) {
+      w.key("nested");
+      serializeType(*t.nested_, w);
+    }
+
+    arr_ptr(w, "generics", t.generics_, [](const Type& g, JsonWriter& w) { serializeType(g, w); });
+    w.endObject();
+  }
+
+  void serializeExpr(const Expression& e, JsonWriter& w) {
+    w.beginObject();
+    w.field("kind", to_int(e.kind_));
+    w.field("literal", to_int(e.literal_));
+    w.field("name", e.name_);
+    w.field("value", e.value_);
+    w.field("raw", e.raw_);
+    w.key("loc");
+    serializeLoc(e.loc_, w);
+
+    arr_ptr(w, "generics", e.generics_, [](const Type& g, JsonWriter& w) { serializeType(g, w); });
+    arr_ptr(w, "args", e.args_, [](const Expression& a, JsonWriter& w) { serializeExpr(a, w); });
+
+    auto child = [&](const char* key, const std::unique_ptr<Expression>& c) {
+      if (!c) return;
+      w.key(key);
+      serializeExpr(*c, w);
+    };
+    child("nested", e.nested_);
+    child("index", e.index_);
+    child("callee", e.callee_);
+    child("lhs", e.lhs_);
+    child("rhs", e.rhs_);
+
+    w.endObject();
+  }
+
+  void serializeStmt(const Statement& s, JsonWriter& w) {
+    auto stmt = [](const Statement& c, JsonWriter& w) { serializeStmt(c, w); };
+
+    w.beginObject();
+    w.field("kind", to_int(s.kind_));
+    w.field("name", s.name_);
+    w.field("public", s.public_);
+    w.field("extern", s.extern_);
+    w.field("async", s.async_);
+    w.field("mutability", to_int(s.mutability));
+    w.field("declare", s.declare_);
+    w.field("variadic", s.variadic_);
+    w.field("import_all", s.import_all_);
+    w.field("import_alias", s.import_alias_);
+
+    w.key("loc");
+    serializeLoc(s.loc_, w);
+
+    if (s.assign_) { w.key("assign"); serializeExpr(*s.assign_, w); }
+    if (s.value_)  { w.key("value");  serializeExpr(*s.value_, w); }
+    if (s.type_)   { w.key("type");   serializeType(*s.type_, w); }
+
+    arr_ptr(w, "import_qualified", s.import_qualified_, stmt);
+    arr_ptr(w, "import_items", s.import_items_, stmt);
+
+    arr_ptr(w, "generics", s.generics_, stmt);
+    arr_ptr(w, "params", s.params_, stmt);
+    arr_ptr(w, "attributes", s.attributes_, stmt);
+    arr_ptr(w, "body", s.body_, stmt);
+    arr_ptr(w, "then", s.then_, stmt);
+    arr_ptr(w, "else", s.else_, stmt);
+    arr_ptr(w, "try", s.try_, stmt);
+    arr_ptr(w, "catch", s.catch_, stmt);
+    arr_ptr(w, "finally", s.finally_, stmt);
+
+    w.endObject();
+  }
+
+  void serializeProgram(const Program& p, JsonWriter& w) {
+    w.beginObject();
+    w.field("name", p.name_);
+    arr_ptr(w, "statements", p.statements_, [](const Statement& s, JsonWriter& w) { serializeStmt(s, w); });
+    w.endObject();
+  }
 };
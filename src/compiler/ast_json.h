@@ -2,6 +2,7 @@
 
 #include <nlohmann/json.hpp>
 #include "ast.h"
+#include "json_writer.h"
 
 namespace sonic::frontend::ast::json {
 
@@ -37,4 +38,11 @@ namespace sonic::frontend::ast::json {
   std::unique_ptr<Statement> deserializeStmt(const json& j);
   json serializeProgram(const Program& p);
   Program deserializeProgram(const json& j);
+
+  // streaming variants, same layout without building a json tree
+  void serializeLoc(const SourceLocation& loc, sonic::io::JsonWriter& w);
+  void serializeType(const Type& t, sonic::io::JsonWriter& w);
+  void serializeExpr(const Expression& e, sonic::io::JsonWriter& w);
+  void serializeStmt(const Statement& s, sonic::io::JsonWriter& w);
+  void serializeProgram(const Program& p, sonic::io::JsonWriter& w);
 }
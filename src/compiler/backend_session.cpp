@@ -0,0 +1,216 @@
+#include "backend_session.h"
+#include "optimizer.h"
+#include "../core/config.h"
+#include "../core/target_info.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <vector>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetOptions.h>
+#include <llvm/TargetParser/Host.h>
+
+namespace cfg = sonic::config;
+
+namespace sonic::backend {
+  namespace {
+    struct TargetInit {
+      const char* name;
+      void (*target)();
+      void (*mc)();
+    };
+
+    struct ComponentInit {
+      const char* name;
+      void (*init)();
+    };
+
+    #define LLVM_TARGET(T) { #T, LLVMInitialize##T##Target, LLVMInitialize##T##TargetMC },
+    const TargetInit targets[] = {
+      #include <llvm/Config/Targets.def>
+    };
+    #undef LLVM_TARGET
+
+    #define LLVM_ASM_PRINTER(T) { #T, LLVMInitialize##T##AsmPrinter },
+    const ComponentInit printers[] = {
+      #include <llvm/Config/AsmPrinters.def>
+    };
+    #undef LLVM_ASM_PRINTER
+
+    #define LLVM_ASM_PARSER(T) { #T, LLVMInitialize##T##AsmParser },
+    const ComponentInit parsers[] = {
+      #include <llvm/Config/AsmParsers.def>
+    };
+    #undef LLVM_ASM_PARSER
+
+    template<typename T, size_t N>
+    const T* find_backend(const T (&table)[N], const char* name) {
+      for (auto& entry : table) {
+        if (std::strcmp(entry.name, name) == 0) return &entry;
+      }
+      return nullptr;
+    }
+  }
+
+  std::vector<std::string> feature_list(const std::string& features) {
+    llvm::SmallVector<llvm::StringRef, 16> parts;
+    llvm::StringRef(features).split(parts, ',', -1, false);
+
+    std::vector<std::string> list;
+    for (auto part : parts) list.push_back(part.trim().str());
+    return list;
+  }
+
+  // sorted, so the string and every cache key built from it is stable
+  static std::string host_features() {
+    std::vector<std::string> features;
+    for (auto& feature : llvm::sys::getHostCPUFeatures()) {
+      features.push_back((feature.second ? "+" : "-") + feature.first().str());
+    }
+    std::sort(features.begin(), features.end());
+    return llvm::join(features, ",");
+  }
+
+  TargetKey default_target_key() {
+    if (cfg::target_platform.empty()) {
+      cfg::target_platform = llvm::sys::getDefaultTargetTriple();
+    }
+    return target_key(cfg::target_platform);
+  }
+
+  TargetKey target_key(const std::string& triple) {
+    TargetKey key;
+    key.triple = triple;
+    bool host = key.triple == llvm::sys::getDefaultTargetTriple();
+
+    std::string cpu = cfg::target_cpu;
+    if (cpu.empty() && host) cpu = "native";
+
+    if (cpu == "native" && !host) {
+      static std::once_flag warned;
+      std::call_once(warned, [&] {
+        std::cerr << "\033[33mwarning:\033[0m --cpu=native ignored for cross target '" << key.triple << "'\n";
+      });
+      cpu.clear();
+    }
+
+    if (cpu == "native") {
+      static const std::string features = host_features();
+      key.cpu = llvm::sys::getHostCPUName().str();
+      key.features = features;
+    } else if (!cpu.empty()) {
+      key.cpu = cpu;
+    } else {
+      key.cpu = target_cpu(key.triple);
+    }
+
+    // explicit features come last so they override the detected ones
+    if (!cfg::target_features.empty()) {
+      if (!key.features.empty()) key.features += ",";
+      key.features += cfg::target_features;
+    }
+    return key;
+  }
+
+  BuildTarget default_build_target() {
+    return {default_target_key(), cfg::project_build};
+  }
+
+  std::vector<BuildTarget> build_targets() {
+    if (cfg::target_platforms.size() <= 1) return {default_build_target()};
+
+    std::vector<BuildTarget> targets;
+    for (auto& triple : cfg::target_platforms) {
+      targets.push_back({target_key(triple), cfg::project_build + "/" + triple});
+    }
+    return targets;
+  }
+
+  BackendSession& BackendSession::get() {
+    static BackendSession session;
+    return session;
+  }
+
+  const llvm::Target* BackendSession::initializeTarget(const llvm::Triple& triple, std::string& error) {
+    static std::once_flag infos;
+    std::call_once(infos, [] {
+      // registers names only, so the triple can be matched to a backend
+      llvm::InitializeAllTargetInfos();
+    });
+
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+    if (!target) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const char* backend = target->getBackendName();
+    if (initialized_.insert(backend).second) {
+      if (auto t = find_backend(targets, backend)) {
+        t->target();
+        t->mc();
+      }
+      if (auto p = find_backend(printers, backend)) p->init();
+      if (auto p = find_backend(parsers, backend)) p->init();
+    }
+
+    return target;
+  }
+
+  std::unique_ptr<llvm::TargetMachine> BackendSession::createTargetMachine(const TargetKey& key) {
+    llvm::Triple triple(key.triple);
+
+    std::string error;
+    const llvm::Target* target = initializeTarget(triple, error);
+    if (!target) {
+      llvm::errs() << "Target error: " << error << "\n";
+      std::abort();
+    }
+
+    llvm::TargetOptions opt;
+    // at -O0 the latency of instruction selection dominates; FastISel
+    // (GlobalISel where the target defaults to it) with the fast register
+    // allocator that CodeGenOptLevel::None selects
+    opt.EnableFastISel = cfg::optimizer_level == cfg::OptLevel::NO;
+
+    // system compiler drivers link position independent executables by default
+    std::optional<llvm::Reloc::Model> reloc;
+    if (!triple.isOSWindows()) reloc = llvm::Reloc::PIC_;
+
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+      triple,
+      key.cpu,
+      key.features,
+      opt,
+      reloc,
+      std::nullopt,
+      codegen_opt_level(cfg::optimizer_level)
+    ));
+  }
+
+  llvm::TargetMachine* BackendSession::targetMachine(const TargetKey& key) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = machines_.find(key);
+      if (it != machines_.end()) return it->second.get();
+    }
+
+    auto machine = createTargetMachine(key);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = machines_[key];
+    if (!slot) slot = std::move(machine);
+    return slot.get();
+  }
+
+  llvm::TargetMachine* BackendSession::threadTargetMachine(const TargetKey& key) {
+    thread_local std::map<TargetKey, std::unique_ptr<llvm::TargetMachine>> local;
+
+    auto& slot = local[key];
+    if (!slot) slot = createTargetMachine(key);
+    return slot.get();
+  }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/TargetParser/Triple.h>
+
+namespace sonic::backend {
+  struct TargetKey {
+    std::string triple;
+    std::string cpu;
+    std::string features;
+
+    bool operator<(const TargetKey& o) const {
+      return std::tie(triple, cpu, features) < std::tie(o.triple, o.cpu, o.features);
+    }
+  };
+
+  // the comma separated `features` of a key, one "+name" / "-name" each
+  std::vector<std::string> feature_list(const std::string& features);
+
+  // `triple` with the --cpu / --features of the command line applied
+  TargetKey target_key(const std::string& triple);
+  // the target requested on the command line (or the host)
+  TargetKey default_target_key();
+
+  // one backend pipeline of a build: the target and the directory its
+  // cache and executable go to
+  struct BuildTarget {
+    TargetKey key;
+    std::string dir;
+  };
+
+  // the first --target, built into build/
+  BuildTarget default_build_target();
+  // every --target; with more than one each builds into build/<triple>/
+  std::vector<BuildTarget> build_targets();
+
+  // process-wide backend state: targets are registered with LLVM only when
+  // a build asks for them, and TargetMachines are created once per
+  // (triple, cpu, features)
+  class BackendSession {
+    public:
+    static BackendSession& get();
+
+    const llvm::Target* initializeTarget(const llvm::Triple& triple, std::string& error);
+
+    // shared machine; use it for queries such as the data layout, not for
+    // emitting code from several threads at once
+    llvm::TargetMachine* targetMachine(const TargetKey& key);
+
+    // machine private to the calling thread, created on its first request
+    llvm::TargetMachine* threadTargetMachine(const TargetKey& key);
+
+    private:
+    BackendSession() = default;
+
+    std::unique_ptr<llvm::TargetMachine> createTargetMachine(const TargetKey& key);
+
+    std::mutex mutex_;
+    std::set<std::string> initialized_;
+    std::map<TargetKey, std::unique_ptr<llvm::TargetMachine>> machines_;
+  };
+};
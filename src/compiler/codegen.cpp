@@ -1,6 +1,13 @@
 #include "codegen.h"
+#include "backend_session.h"
+#include "debug_info.h"
+#include "multiversion.h"
+#include "object_cache.h"
+#include "split_codegen.h"
 #include "../core/config.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <iostream>
 #include <llvm/ADT/Twine.h>
@@ -19,9 +26,13 @@
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "../core/io.h"
@@ -33,97 +44,296 @@
 namespace cfg = sonic::config;
 
 namespace sonic::backend {
-  SonicCodegen::SonicCodegen(Symbol* symbol) : symbols(symbol) {
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmPrinters();
-    llvm::InitializeAllAsmParsers();
-
-    if (cfg::target_platform.empty()) {
-      cfg::target_platform = llvm::sys::getDefaultTargetTriple();
-    }
-
-    std::string cpu;
-    if (cfg::target_platform == llvm::sys::getDefaultTargetTriple()) {
-      cpu = llvm::sys::getHostCPUName();
-    } else {
-      cpu = target_cpu(cfg::target_platform);
+  // variables whose address escapes through `&x` have to stay in memory
+  static void collect_address_taken(ast::Expression* expr, std::unordered_set<Symbol*>& out) {
+    if (!expr) return;
+    if (expr->kind_ == ast::ExprKind::REF && expr->nested_ && expr->nested_->symbols_) {
+      out.insert((Symbol*)expr->nested_->symbols_);
     }
 
-    llvm::Triple triple(cfg::target_platform);
+    collect_address_taken(expr->nested_.get(), out);
+    collect_address_taken(expr->index_.get(), out);
+    collect_address_taken(expr->callee_.get(), out);
+    collect_address_taken(expr->lhs_.get(), out);
+    collect_address_taken(expr->rhs_.get(), out);
+    for (auto& arg : expr->args_) collect_address_taken(arg.get(), out);
+  }
 
-    module = std::make_unique<llvm::Module>("sonic_module", context);
-    module->setTargetTriple(triple);
+  static void collect_address_taken(ast::Statement* stmt, std::unordered_set<Symbol*>& out) {
+    // nested functions are collected when they are generated
+    if (!stmt || stmt->kind_ == ast::StmtKind::FUNCTION) return;
 
-    std::string error;
-    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
-    if (!target) {
-      llvm::errs() << "Target error: " << error << "\n";
-      std::abort();
+    collect_address_taken(stmt->assign_.get(), out);
+    collect_address_taken(stmt->value_.get(), out);
+    for (auto* block : {&stmt->body_, &stmt->then_, &stmt->else_, &stmt->try_, &stmt->catch_, &stmt->finally_}) {
+      for (auto& child : *block) collect_address_taken(child.get(), out);
     }
+  }
 
-    llvm::TargetOptions opt;
-    auto features = "";
-
-    targetMachine = target->createTargetMachine(
-      triple,
-      cpu,
-      features,
-      opt,
-      std::nullopt
-    );
+  SonicCodegen::SonicCodegen(Symbol* symbol, const BuildTarget& build)
+  : owned_context(std::make_unique<llvm::LLVMContext>()), context(*owned_context), symbols(symbol) {
+    target = build.key;
+    build_dir_ = build.dir;
+    // passes query the TargetMachine's subtarget cache, so every worker
+    // thread gets its own machine
+    targetMachine = BackendSession::get().threadTargetMachine(target);
 
+    module = std::make_unique<llvm::Module>("sonic_module", context);
+    module->setTargetTriple(llvm::Triple(target.triple));
     module->setDataLayout(targetMachine->createDataLayout());
 
     builder = std::make_unique<llvm::IRBuilder<>>(context);
+    // -Ofast: floating point math may be reassociated and contracted and
+    // assumes no NaN or infinity, which the loop vectorizer needs to turn
+    // reductions into vector code; IRBuilder attaches the flags to every
+    // floating point operation it creates
+    if (cfg::optimizer_level == cfg::OptLevel::OFAST) {
+      llvm::FastMathFlags fmf;
+      fmf.setFast();
+      builder->setFastMathFlags(fmf);
+    }
+    if (cfg::optimizer_level != cfg::OptLevel::NO) tbaa_ = std::make_unique<TypeAliasInfo>(context);
+    optimizer = std::make_unique<Optimizer>(context, targetMachine, cfg::optimizer_level);
   }
 
   SonicCodegen::~SonicCodegen() {
-    delete targetMachine;
+    optimizer.reset();
   }
 
   void SonicCodegen::saveBitcode(const std::string& path) {
-    std::string output_file = cfg::project_build + "/cache/" + sonic::io::getFileNameWithoutExt(path) + ".bc";
+    std::string output_file = build_dir_ + "/cache/" + sonic::io::getFileNameWithoutExt(path) + ".bc";
     sonic::io::create_file_and_folder(output_file);
 
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(output_file, EC, llvm::sys::fs::OF_Text | llvm::sys::fs::OF_Append);
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream dest(buffer);
+    llvm::WriteBitcodeToFile(*module, dest);
 
-    if (EC) {
-      llvm::errs() << "Could not open file for writing bitcode: " << EC.message() << "\n";
-      return;
+    if (!sonic::io::write_file_atomic(output_file, std::string_view(buffer.data(), buffer.size()))) {
+      llvm::errs() << "Could not write file: " << output_file << "\n";
     }
+  }
 
-    llvm::WriteBitcodeToFile(*module, dest);
+  void SonicCodegen::saveLLReadable(const std::string& path) {
+    std::string output_file = build_dir_ + "/cache/" + sonic::io::getFileNameWithoutExt(path) + ".ll";
+    sonic::io::create_file_and_folder(output_file);
+
+    std::string text;
+    llvm::raw_string_ostream dest(text);
+    module->print(dest, nullptr);
     dest.flush();
+
+    if (!sonic::io::write_file_atomic(output_file, text)) {
+      llvm::errs() << "Could not write file: " << output_file << "\n";
+    }
   }
 
-  void SonicCodegen::saveLLReadable(const std::string& path) {
-    std::string output_file = cfg::project_build + "/cache/" + sonic::io::getFileNameWithoutExt(path) + ".ll";
+  bool SonicCodegen::emitFile(const std::string& path, llvm::CodeGenFileType type) {
+    const char* ext = type == llvm::CodeGenFileType::ObjectFile ? ".o" : ".s";
+    std::string output_file = build_dir_ + "/cache/" + sonic::io::getFileNameWithoutExt(path) + ext;
     sonic::io::create_file_and_folder(output_file);
 
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(output_file, EC, llvm::sys::fs::OF_Text | llvm::sys::fs::OF_Append);
+    // emit into memory and write once, so a failed emission leaves no
+    // truncated object behind
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream dest(buffer);
+
+    llvm::legacy::PassManager pm;
+    if (targetMachine->addPassesToEmitFile(pm, dest, nullptr, type, !verify_ir())) {
+      llvm::errs() << "Target machine cannot emit " << (type == llvm::CodeGenFileType::ObjectFile ? "object" : "assembly") << " files\n";
+      return false;
+    }
+
+    // the codegen passes rewrite the IR they run on; assembly is emitted
+    // from a copy, so an object emitted afterwards still matches it
+    std::unique_ptr<llvm::Module> copy;
+    if (type == llvm::CodeGenFileType::AssemblyFile) copy = llvm::CloneModule(*module);
+    pm.run(copy ? *copy : *module);
+
+    std::string_view content(buffer.data(), buffer.size());
+    if (type == llvm::CodeGenFileType::ObjectFile) return writeObject(output_file, content);
+
+    if (!sonic::io::write_file_atomic(output_file, content)) {
+      llvm::errs() << "Could not write file: " << output_file << "\n";
+      return false;
+    }
+    return true;
+  }
+
+  bool SonicCodegen::emitSplitObjects(const std::string& path) {
+    std::vector<llvm::SmallVector<char, 0>> objects;
+    if (!emit_split_objects(*module, target, split_jobs, objects)) {
+      llvm::errs() << "Could not emit object files for: " << path << "\n";
+      return false;
+    }
+
+    std::string base = build_dir_ + "/cache/" + sonic::io::getFileNameWithoutExt(path);
+    sonic::io::create_file_and_folder(base + ".part0.o");
+
+    for (size_t i = 0; i < objects.size(); i++) {
+      std::string output_file = base + ".part" + std::to_string(i) + ".o";
+      if (!writeObject(output_file, std::string_view(objects[i].data(), objects[i].size()))) return false;
+    }
+    return true;
+  }
+
+  bool SonicCodegen::writeObject(const std::string& output_file, std::string_view object) {
+    if (!sonic::io::write_file_atomic(output_file, object)) {
+      llvm::errs() << "Could not write file: " << output_file << "\n";
+      return false;
+    }
+
+    objects_.push_back(output_file);
+    if (!object_key_.empty()) emitted_.emplace_back(object);
+    return true;
+  }
+
+  bool SonicCodegen::loadCachedObjects(const std::string& path, const std::string& key) {
+    std::vector<std::string> objects;
+    if (!object_store->load(key, objects)) return false;
+
+    // found by the IR: the next build can skip lowering too
+    if (key != source_key_ && !source_key_.empty()) {
+      std::vector<std::string_view> views(objects.begin(), objects.end());
+      object_store->store(source_key_, views);
+    }
+
+    // same names as a fresh build, so stale partitions are never linked
+    std::string base = build_dir_ + "/cache/" + sonic::io::getFileNameWithoutExt(path);
+    sonic::io::create_file_and_folder(base + ".o");
+
+    for (size_t i = 0; i < objects.size(); i++) {
+      std::string output_file = objects.size() == 1 ? base + ".o" : base + ".part" + std::to_string(i) + ".o";
+      if (!sonic::io::write_file_atomic(output_file, objects[i])) {
+        objects_.clear();
+        return false;
+      }
+      objects_.push_back(output_file);
+    }
+    return true;
+  }
+
+  bool SonicCodegen::emitLtoBitcode(const std::string& path) {
+    bool thin = cfg::lto_mode == cfg::LTO_THIN;
+    std::string output_file = build_dir_ + "/cache/" + sonic::io::getFileNameWithoutExt(path) + (thin ? ".thin.bc" : ".full.bc");
+    sonic::io::create_file_and_folder(output_file);
 
-    if (EC) {
-      llvm::errs() << "Could not open file: " << EC.message();
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream dest(buffer);
+    if (thin) {
+      // the summary lets the thin link pick imports without loading modules
+      llvm::ModuleSummaryIndex index = llvm::buildModuleSummaryIndex(*module, nullptr, nullptr);
+      llvm::WriteBitcodeToFile(*module, dest, false, &index);
     } else {
-      module->print(dest, nullptr);
+      llvm::WriteBitcodeToFile(*module, dest);
+    }
+
+    if (!sonic::io::write_file_atomic(output_file, std::string_view(buffer.data(), buffer.size()))) {
+      llvm::errs() << "Could not write file: " << output_file << "\n";
+      return false;
     }
+
+    objects_.push_back(output_file);
+    return true;
   }
 
-  void SonicCodegen::generate(ast::Program* program) {
+  bool SonicCodegen::lower(ast::Program* program) {
+    module->setModuleIdentifier(program->name_);
+    module->setSourceFileName(program->name_);
+
+    if (cfg::debug_info != cfg::DEBUG_NONE) {
+      debug_ = std::make_unique<DebugInfo>(*module, program->name_, cfg::project_root, cfg::debug_info == cfg::DEBUG_LINE_TABLES);
+    }
+
     for (auto& s : program->statements_) {
       generate_statement(s.get());
     }
 
-    saveBitcode(sonic::io::cutPath(program->name_, "src"));
-    saveLLReadable(sonic::io::cutPath(program->name_, "src"));
+    if (debug_) debug_->finalize();
+    return !failed_;
+  }
+
+  // the module is still finished, so later statements report their own
+  // errors, but it is never optimized, emitted or cached
+  void SonicCodegen::error(const SourceLocation& loc, const std::string& message) {
+    std::cerr << "\033[31merror:\033[0m " << loc.path << ":" << loc.line << ":" << loc.column << ": " << message << "\n";
+    failed_ = true;
+  }
+
+  bool SonicCodegen::generateIR(ast::Program* program) {
+    if (program->hasLazyBodies()) {
+      std::cerr << "\033[31merror:\033[0m function bodies of '" << program->name_ << "' were not analyzed\n";
+      return false;
+    }
+
+    if (!lower(program)) return false;
+    return optimizer->runOnModule(*module);
+  }
+
+  llvm::orc::ThreadSafeModule SonicCodegen::takeModule() {
+    // analysis results refer to the module, drop them while it is still here
+    optimizer.reset();
+    builder.reset();
+    return llvm::orc::ThreadSafeModule(std::move(module), std::move(owned_context));
+  }
+
+  bool SonicCodegen::generate(ast::Program* program) {
+    std::string path = sonic::io::cutPath(program->name_, "src");
+
+    // a cached module whose source key hits is neither lowered nor has
+    // its function bodies decoded
+    bool cacheable = object_store && objects_cacheable();
+    if (cacheable) {
+      source_key_ = object_store->keyForSource(*program, interface_key);
+      if (!source_key_.empty() && loadCachedObjects(path, source_key_)) return true;
+    }
+
+    if (program->hasLazyBodies()) {
+      std::cerr << "\033[31merror:\033[0m function bodies of '" << program->name_ << "' were not analyzed\n";
+      return false;
+    }
+
+    if (!lower(program)) return false;
+
+    // compiled ahead of time only; the JIT already targets the host CPU
+    for (auto& [fn, levels] : multiversioned_) {
+      std::string error;
+      if (!emit_multiversion(*module, fn, levels, error)) {
+        std::cerr << "\033[33mwarning:\033[0m multiversion of '" << fn->getName().str() << "' skipped: " << error << "\n";
+      }
+    }
+
+    if (cacheable) {
+      object_key_ = object_store->keyFor(*module);
+      if (loadCachedObjects(path, object_key_)) return true;
+    }
+
+    if (!optimizer->runOnModule(*module)) return false;
+
+    if (cfg::emit_kinds & cfg::EMIT_BC) saveBitcode(path);
+    if (cfg::emit_kinds & cfg::EMIT_LL) saveLLReadable(path);
+    if (cfg::emit_kinds & cfg::EMIT_ASM) emitFile(path, llvm::CodeGenFileType::AssemblyFile);
+    if (cfg::emit_kinds & cfg::EMIT_OBJ) {
+      bool emitted;
+      if (cfg::lto_mode != cfg::LTO_NONE) emitted = emitLtoBitcode(path);
+      else if (split_jobs > 1) emitted = emitSplitObjects(path);
+      else emitted = emitFile(path, llvm::CodeGenFileType::ObjectFile);
+
+      if (!emitted) return false;
+
+      if (!object_key_.empty()) {
+        std::vector<std::string_view> objects(emitted_.begin(), emitted_.end());
+        object_store->store(object_key_, objects);
+        if (!source_key_.empty()) object_store->store(source_key_, objects);
+      }
+    }
+    return true;
   }
 
   void SonicCodegen::generate_statement(ast::Statement* stmt) {
     if (!stmt) return;
 
+    if (debug_) builder->SetCurrentDebugLocation(debug_->location(stmt->loc_));
+
     switch(stmt->kind_) {
       case ast::StmtKind::IMPORT: {
         for (auto& item : stmt->import_items_) {
@@ -140,57 +350,8 @@ namespace sonic::backend {
             return;
           }
 
-          // Return type
-          llvm::Type* retType = llvm::Type::getVoidTy(context);
-          if (fnSym->type_) retType = mapping_type(fnSym->type_);
-          else {
-            retType = llvm::Type::getVoidTy(context);
-          }
-
-          // Parameter types
-          std::vector<llvm::Type*> paramTypes;
-          for (auto& p : fnSym->params_) {
-            auto t = mapping_type(p);
-            if (!t) {
-              t = llvm::Type::getInt64Ty(context);
-            }
-            paramTypes.push_back(t);
-          }
-
-          if (!retType) {
-            break;
-          }
-          
-          // Validate all parameter types before creating FunctionType
-          for (size_t i = 0; i < paramTypes.size(); i++) {
-            if (!paramTypes[i]) {
-              paramTypes[i] = llvm::Type::getInt64Ty(context);
-            }
-            // Make sure it's not a FunctionType
-            if (paramTypes[i]->isFunctionTy()) {
-              std::cerr << "Error: parameter " << i << " cannot be a FunctionType for: " << fnSym->name_ << std::endl;
-              paramTypes[i] = llvm::Type::getInt64Ty(context);
-            }
-          }
-          
-          // Return type also cannot be a FunctionType
-          if (retType->isFunctionTy()) {
-            retType = llvm::Type::getVoidTy(context);
-          }
-
-          auto funcType = llvm::FunctionType::get(retType, paramTypes, fnSym->variadic_);
-          if (!funcType) {
-            break;
-          }
-          
-          auto func = llvm::Function::Create(funcType, (fnSym->public_ || fnSym->extern_ || fnSym->async_) ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage, fnSym->name_, module.get());
-          
-          if (!func) {
-            break;
-          }
-          
-          fnSym->llvm_function_= func;
-          symbols->declare(fnSym);
+          // defined by another module, resolved by name at link time
+          declareFunction(fnSym);
         }
         break;
       }
@@ -207,81 +368,44 @@ namespace sonic::backend {
           return;
         }
 
-        // Return type
-        llvm::Type* retType = llvm::Type::getVoidTy(context);
-        if (fnSym->type_) retType = mapping_type(fnSym->type_);
-        else {
-          retType = llvm::Type::getVoidTy(context);
-        }
-
-        // Parameter types
-        std::vector<llvm::Type*> paramTypes;
-        for (auto& p : fnSym->params_) {
-          auto t = mapping_type(p);
-          if (!t) {
-            t = llvm::Type::getInt64Ty(context);
-          }
-          paramTypes.push_back(t);
-        }
-
-        if (!retType) {
-          break;
-        }
-        
-        // Validate all parameter types before creating FunctionType
-        for (size_t i = 0; i < paramTypes.size(); i++) {
-          if (!paramTypes[i]) {
-            paramTypes[i] = llvm::Type::getInt64Ty(context);
-          }
-          // Make sure it's not a FunctionType
-          if (paramTypes[i]->isFunctionTy()) {
-            std::cerr << "Error: parameter " << i << " cannot be a FunctionType for: " << fnSym->name_ << std::endl;
-            paramTypes[i] = llvm::Type::getInt64Ty(context);
-          }
-        }
-        
-        // Return type also cannot be a FunctionType
-        if (retType->isFunctionTy()) {
-          retType = llvm::Type::getVoidTy(context);
-        }
-
-        auto funcType = llvm::FunctionType::get(retType, paramTypes, fnSym->variadic_);
-        if (!funcType) {
-          break;
-        }
-        
-        auto func = llvm::Function::Create(funcType, (fnSym->public_ || fnSym->extern_ || fnSym->async_) ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage, fnSym->name_, module.get());
-        
+        auto func = declareFunction(fnSym);
         if (!func) {
           break;
         }
-        
-        fnSym->llvm_function_= func;
+        llvm::Type* retType = func->getReturnType();
+
 
         if (fnSym->decl_) break; // only declaration
+        if (!func->empty()) break; // already defined in this module
 
         // Create entry block
         auto entry = llvm::BasicBlock::Create(context, "entry", func);
         builder->SetInsertPoint(entry);
 
+        if (debug_) {
+          debug_->beginFunction(func, stmt->name_, stmt->loc_);
+          builder->SetCurrentDebugLocation(debug_->location(stmt->loc_));
+        }
+
         // Set current function symbol for local declarations
         current_function_ = fnSym;
+        scopes_.clear();
+        ssa_.clear();
+        ssa_.sealBlock(entry);
+        debug_variables_.clear();
 
-        // Allocate and store parameters into local allocas
+        address_taken_.clear();
+        for (auto& b : stmt->body_) collect_address_taken(b.get(), address_taken_);
+
+        // parameters are locals that start out with the argument value
         size_t idx = 0;
         for (auto& arg : func->args()) {
-          std::string pname = "arg" + std::to_string(idx);
-          if (idx < stmt->params_.size() && stmt->params_[idx]) pname = stmt->params_[idx]->name_;
-
-          llvm::AllocaInst* alloca = builder->CreateAlloca(arg.getType(), nullptr, pname + "_addr");
-          builder->CreateStore(&arg, alloca);
-
-          // create param symbol and declare under function symbol so expressions can find it
-          auto paramSym = new Symbol(pname);
-          paramSym->kind_ = SymbolKind::VARIABLE;
-          paramSym->llvm_value_ = alloca;
-          fnSym->declare(paramSym);
+          ast::Statement* param = idx < stmt->params_.size() ? stmt->params_[idx].get() : nullptr;
+          std::string pname = param ? param->name_ : "arg" + std::to_string(idx);
+          arg.setName(pname);
 
+          Symbol* paramSym = param ? (Symbol*)param->symbols_ : nullptr;
+          defineLocal(paramSym, pname, arg.getType(), &arg, param ? param->loc_ : stmt->loc_, idx + 1);
           idx++;
         }
 
@@ -291,11 +415,26 @@ namespace sonic::backend {
         }
 
         // Ensure function has a terminator
-        if (!entry->getTerminator()) {
+        if (!builder->GetInsertBlock()->getTerminator()) {
           if (retType->isVoidTy()) builder->CreateRetVoid();
           else builder->CreateRet(llvm::Constant::getNullValue(retType));
         }
 
+        if (debug_) {
+          debug_->endFunction();
+          builder->SetCurrentDebugLocation(llvm::DebugLoc());
+        }
+
+        optimizer->runOnFunction(*func);
+
+        for (auto& attr : stmt->attributes_) {
+          if (attr->name_ != "multiversion") continue;
+
+          std::vector<std::string> levels;
+          for (auto& arg : attr->params_) levels.push_back(arg->name_);
+          multiversioned_.emplace_back(func, std::move(levels));
+        }
+
         // clear current function
         current_function_ = nullptr;
 
@@ -313,47 +452,45 @@ namespace sonic::backend {
         if (!ty) ty = llvm::Type::getInt64Ty(context);
 
         // initializer
-        llvm::Constant* init = nullptr;
-        if (stmt->value_) {
-          auto val = generate_expression(stmt->value_.get());
-          if (val && llvm::isa<llvm::Constant>(val)) init = llvm::cast<llvm::Constant>(val);
-        }
+        llvm::Value* value = stmt->value_ ? generate_expression(stmt->value_.get()) : nullptr;
 
         if (!current_function_) {
           // create global variable
           llvm::GlobalVariable* gv = new llvm::GlobalVariable(*module, ty, false, llvm::GlobalValue::ExternalLinkage, nullptr, stmt->name_);
-          if (init) gv->setInitializer(init);
-          if (varSym) varSym->llvm_value_ = gv;
+          if (auto init = llvm::dyn_cast_or_null<llvm::Constant>(value)) gv->setInitializer(init);
+          if (varSym) values_[varSym] = gv;
         } else {
-          // local variable: create alloca in current function's entry block
-          llvm::Function* f = builder->GetInsertBlock()->getParent();
-          llvm::IRBuilder<> tmpBuilder(&f->getEntryBlock(), f->getEntryBlock().begin());
-          llvm::AllocaInst* alloca = tmpBuilder.CreateAlloca(ty, nullptr, stmt->name_ + "_addr");
-
-          if (stmt->value_) {
-            auto val = generate_expression(stmt->value_.get());
-            if (val) builder->CreateStore(val, alloca);
-          } else {
-            // default initialize to zero
-            builder->CreateStore(llvm::Constant::getNullValue(ty), alloca);
-          }
+          // default initialize to zero
+          value = value ? coerce(value, ty) : llvm::Constant::getNullValue(ty);
+          defineLocal(varSym, stmt->name_, ty, value, stmt->loc_, 0);
+        }
 
-          if (varSym) varSym->llvm_value_ = alloca;
-          // also register symbol under current function if not present
-          if (!current_function_->exists(stmt->name_)) {
-            auto s = new Symbol(stmt->name_);
-            s->kind_ = SymbolKind::VARIABLE;
-            s->llvm_value_ = alloca;
-            current_function_->declare(s);
-          }
+        break;
+      }
+      case ast::StmtKind::ASSIGNMENT: {
+        if (stmt->assign_ && stmt->assign_->kind_ == ast::ExprKind::INDEX) {
+          ast::Type* element = nullptr;
+          llvm::Value* address = elementAddress(stmt->assign_.get(), element);
+          llvm::Value* value = generate_expression(stmt->value_.get());
+          if (!address || !value) break;
+
+          store(coerce(value, mapping_type(element)), address, element);
+          break;
         }
 
+        Symbol* target = stmt->assign_ ? (Symbol*)stmt->assign_->symbols_ : nullptr;
+        llvm::Value* value = generate_expression(stmt->value_.get());
+        if (!target || !value) break;
+
+        if (target->kind_ == SymbolKind::ALIAS) target = target->ref_;
+        assignVariable(target, value, stmt->loc_);
         break;
       }
       case ast::StmtKind::RETURN: {
         if (stmt->value_) {
           auto retv = generate_expression(stmt->value_.get());
-          if (retv) builder->CreateRet(retv);
+          llvm::Type* type = builder->GetInsertBlock()->getParent()->getReturnType();
+          if (retv) builder->CreateRet(coerce(retv, type));
         } else {
           builder->CreateRetVoid();
         }
@@ -364,10 +501,88 @@ namespace sonic::backend {
         generate_expression(stmt->value_.get());
         break;
       }
+      case ast::StmtKind::IF_ELSE: {
+        if (!current_function_) break;
+        llvm::Value* cond = toBool(generate_expression(stmt->value_.get()));
+        if (!cond) {
+          error(stmt->loc_, "condition of 'if' cannot be used as bool");
+          break;
+        }
+
+        llvm::Function* fn = builder->GetInsertBlock()->getParent();
+        auto thenBlock = llvm::BasicBlock::Create(context, "if.then", fn);
+        auto elseBlock = stmt->else_.empty() ? nullptr : llvm::BasicBlock::Create(context, "if.else", fn);
+        auto end = llvm::BasicBlock::Create(context, "if.end", fn);
+
+        builder->CreateCondBr(cond, thenBlock, elseBlock ? elseBlock : end);
+        ssa_.sealBlock(thenBlock);
+
+        builder->SetInsertPoint(thenBlock);
+        generate_block(stmt->then_);
+        if (!builder->GetInsertBlock()->getTerminator()) builder->CreateBr(end);
+
+        if (elseBlock) {
+          ssa_.sealBlock(elseBlock);
+          builder->SetInsertPoint(elseBlock);
+          generate_block(stmt->else_);
+          if (!builder->GetInsertBlock()->getTerminator()) builder->CreateBr(end);
+        }
+
+        ssa_.sealBlock(end);
+        builder->SetInsertPoint(end);
+        break;
+      }
+      case ast::StmtKind::WHILE_LOOP: {
+        if (!current_function_) break;
+
+        llvm::Function* fn = builder->GetInsertBlock()->getParent();
+        auto condBlock = llvm::BasicBlock::Create(context, "while.cond", fn);
+        auto body = llvm::BasicBlock::Create(context, "while.body", fn);
+        auto end = llvm::BasicBlock::Create(context, "while.end", fn);
+
+        // the condition block is sealed once the back edge exists
+        builder->CreateBr(condBlock);
+        builder->SetInsertPoint(condBlock);
+        llvm::Value* cond = toBool(generate_expression(stmt->value_.get()));
+        if (!cond) {
+          error(stmt->loc_, "condition of 'while' cannot be used as bool");
+          cond = builder->getFalse();
+        }
+        builder->CreateCondBr(cond, body, end);
+        ssa_.sealBlock(body);
+
+        builder->SetInsertPoint(body);
+        generate_block(stmt->body_);
+        if (!builder->GetInsertBlock()->getTerminator()) builder->CreateBr(condBlock);
+
+        ssa_.sealBlock(condBlock);
+        ssa_.sealBlock(end);
+        builder->SetInsertPoint(end);
+        break;
+      }
       default: return;
     }
   }
 
+  // body of an `if` / `while`. Locals kept in memory get their alloca in
+  // the entry block like any other, but are only live between a
+  // lifetime.start at their declaration and a lifetime.end where the block
+  // closes, so the stack coloring pass can give the slots of disjoint
+  // blocks the same frame offset
+  void SonicCodegen::generate_block(std::vector<std::unique_ptr<ast::Statement>>& body) {
+    scopes_.emplace_back();
+    for (auto& st : body) {
+      // nothing after a return is reachable
+      if (builder->GetInsertBlock()->getTerminator()) break;
+      generate_statement(st.get());
+    }
+
+    if (!builder->GetInsertBlock()->getTerminator()) {
+      for (auto it = scopes_.back().rbegin(); it != scopes_.back().rend(); ++it) builder->CreateLifetimeEnd(*it);
+    }
+    scopes_.pop_back();
+  }
+
   llvm::Value* SonicCodegen::generate_expression(ast::Expression* expr) {
     if (!expr) return nullptr;
 
@@ -402,7 +617,7 @@ namespace sonic::backend {
             return llvm::ConstantInt::get(llvm::Type::getInt8Ty(context), c);
           }
           case ast::LiteralKind::STRING: {
-            return builder->CreateGlobalStringPtr(expr->value_);
+            return stringLiteral(expr->value_);
           }
           default: return nullptr;
         }
@@ -420,19 +635,20 @@ namespace sonic::backend {
           s = s->ref_;
         }
         
-        if (s->kind_ == SymbolKind::FUNCTION) {
-          expr->symbols_ = s;
-          return s->llvm_value_;
+        if (s->kind_ == SymbolKind::FUNCTION) return declareFunction(s);
+
+        if (ssa_.typeOf(s)) {
+          return ssa_.readVariable(s, builder->GetInsertBlock());
         }
 
-        if (s->llvm_value_) {
-          if (auto ai = llvm::dyn_cast<llvm::AllocaInst>(s->llvm_value_)) {
-            return builder->CreateLoad(ai->getAllocatedType(), ai);
+        if (auto value = valueOf(s)) {
+          if (auto ai = llvm::dyn_cast<llvm::AllocaInst>(value)) {
+            return load(ai->getAllocatedType(), ai, s->type_);
           }
-          if (auto gv = llvm::dyn_cast<llvm::GlobalVariable>(s->llvm_value_)) {
-            return builder->CreateLoad(gv->getValueType(), gv);
+          if (auto gv = llvm::dyn_cast<llvm::GlobalVariable>(value)) {
+            return load(gv->getValueType(), gv, s->type_);
           }
-          return s->llvm_value_;
+          return value;
         }
 
         std::cout << "Warning: Variable " << expr->name_ << " has no LLVM value." << std::endl;
@@ -450,7 +666,7 @@ namespace sonic::backend {
           std::cerr << "Error: Unable to find function symbol for call expression" << std::endl;
           return nullptr;
         }
-        llvm::Function* callee = fnsym->llvm_function_;
+        llvm::Function* callee = declareFunction(fnsym);
 
         if (callee == nullptr) {
           std::cerr << "Error: Unable to find function for call: " << fnsym->name_ << std::endl;
@@ -459,9 +675,13 @@ namespace sonic::backend {
 
         // Generate arguments
         std::vector<llvm::Value*> args;
+        llvm::FunctionType* type = callee->getFunctionType();
         for (auto& a : expr->args_) {
           auto arg = generate_expression(a.get());
-          if (arg) args.push_back(arg);
+          if (!arg) continue;
+          // variadic arguments past the declared ones keep their own type
+          if (args.size() < type->getNumParams()) arg = coerce(arg, type->getParamType(args.size()));
+          args.push_back(arg);
         }
         
         if (fnsym->variadic_) {
@@ -478,10 +698,54 @@ namespace sonic::backend {
         if (!scopeSym) return nullptr;
         auto child = scopeSym->lookup(expr->name_);
         if (!child) return nullptr;
-        if (child->llvm_value_) {
-          if (auto ai = llvm::dyn_cast<llvm::AllocaInst>(child->llvm_value_)) return builder->CreateLoad(ai->getAllocatedType(), ai);
-          if (auto gv = llvm::dyn_cast<llvm::GlobalVariable>(child->llvm_value_)) return builder->CreateLoad(gv->getValueType(), gv);
-          return child->llvm_value_;
+        if (auto value = valueOf(child)) {
+          if (auto ai = llvm::dyn_cast<llvm::AllocaInst>(value)) return load(ai->getAllocatedType(), ai, child->type_);
+          if (auto gv = llvm::dyn_cast<llvm::GlobalVariable>(value)) return load(gv->getValueType(), gv, child->type_);
+          return value;
+        }
+        return nullptr;
+      }
+      case ast::ExprKind::REF: {
+        ast::Expression* nested = expr->nested_.get();
+        if (!nested) return nullptr;
+
+        if (nested->kind_ == ast::ExprKind::DEREF || nested->kind_ == ast::ExprKind::INDEX) {
+          ast::Type* element = nullptr;
+          return elementAddress(nested, element);
+        }
+
+        // locals whose address is taken live in an alloca, see collect_address_taken
+        Symbol* s = nested->symbols_ ? (Symbol*)nested->symbols_ : nullptr;
+        if (s && s->kind_ == SymbolKind::ALIAS) s = s->ref_;
+        if (!s) return nullptr;
+        if (s->kind_ == SymbolKind::FUNCTION) return declareFunction(s);
+        return valueOf(s);
+      }
+      case ast::ExprKind::DEREF:
+      case ast::ExprKind::INDEX: {
+        ast::Type* element = nullptr;
+        llvm::Value* address = elementAddress(expr, element);
+        if (!address) return nullptr;
+        return load(mapping_type(element), address, element);
+      }
+      case ast::ExprKind::BINARY: {
+        return generate_binary(expr);
+      }
+      case ast::ExprKind::UNARY: {
+        llvm::Value* value = generate_expression(expr->nested_.get());
+        if (!value) return nullptr;
+
+        if (expr->value_ == "!") {
+          llvm::Value* cond = toBool(value);
+          if (!cond) {
+            error(expr->loc_, "operand of '!' cannot be used as bool");
+            return nullptr;
+          }
+          return builder->CreateNot(cond);
+        }
+        if (expr->value_ == "-") {
+          if (value->getType()->isFloatingPointTy()) return builder->CreateFNeg(value);
+          if (value->getType()->isIntegerTy()) return builder->CreateNSWNeg(value);
         }
         return nullptr;
       }
@@ -492,6 +756,375 @@ namespace sonic::backend {
     }
   }
 
+  llvm::Value* SonicCodegen::generate_binary(ast::Expression* expr) {
+    std::string op = expr->value_;
+    if (op == "&&" || op == "||") return generate_logical(expr, op == "&&");
+
+    // the value of a compound assignment: x += y is x = x + y
+    if (op.size() > 1 && op.back() == '=' && op != "==" && op != "!=" && op != "<=" && op != ">=") op.pop_back();
+
+    llvm::Value* lhs = generate_expression(expr->lhs_.get());
+    llvm::Value* rhs = generate_expression(expr->rhs_.get());
+    if (!lhs || !rhs) return nullptr;
+
+    if (op == "**" || op == "^") return generate_power(lhs, rhs);
+
+    balance(lhs, rhs);
+    llvm::Type* type = lhs->getType();
+
+    if (type->isFloatingPointTy()) {
+      if (op == "+") return builder->CreateFAdd(lhs, rhs);
+      if (op == "-") return builder->CreateFSub(lhs, rhs);
+      if (op == "*") return builder->CreateFMul(lhs, rhs);
+      if (op == "/") return builder->CreateFDiv(lhs, rhs);
+      if (op == "%") return builder->CreateFRem(lhs, rhs);
+      if (op == "<") return builder->CreateFCmpOLT(lhs, rhs);
+      if (op == "<=") return builder->CreateFCmpOLE(lhs, rhs);
+      if (op == ">") return builder->CreateFCmpOGT(lhs, rhs);
+      if (op == ">=") return builder->CreateFCmpOGE(lhs, rhs);
+      if (op == "==") return builder->CreateFCmpOEQ(lhs, rhs);
+      if (op == "!=") return builder->CreateFCmpUNE(lhs, rhs);
+      return nullptr;
+    }
+
+    if (type->isIntegerTy()) {
+      // sonic integers are signed and overflowing them is undefined, so
+      // induction variables can be widened and loops vectorized; bool
+      // compares as unsigned so that true > false
+      bool flag = !type->isIntegerTy(1);
+      if (op == "+") return builder->CreateAdd(lhs, rhs, "", false, flag);
+      if (op == "-") return builder->CreateSub(lhs, rhs, "", false, flag);
+      if (op == "*") return builder->CreateMul(lhs, rhs, "", false, flag);
+      if (op == "/") return builder->CreateSDiv(lhs, rhs);
+      if (op == "%") return builder->CreateSRem(lhs, rhs);
+      if (op == "<") return flag ? builder->CreateICmpSLT(lhs, rhs) : builder->CreateICmpULT(lhs, rhs);
+      if (op == "<=") return flag ? builder->CreateICmpSLE(lhs, rhs) : builder->CreateICmpULE(lhs, rhs);
+      if (op == ">") return flag ? builder->CreateICmpSGT(lhs, rhs) : builder->CreateICmpUGT(lhs, rhs);
+      if (op == ">=") return flag ? builder->CreateICmpSGE(lhs, rhs) : builder->CreateICmpUGE(lhs, rhs);
+      if (op == "==") return builder->CreateICmpEQ(lhs, rhs);
+      if (op == "!=") return builder->CreateICmpNE(lhs, rhs);
+      return nullptr;
+    }
+
+    if (type->isPointerTy()) {
+      if (op == "==") return builder->CreateICmpEQ(lhs, rhs);
+      if (op == "!=") return builder->CreateICmpNE(lhs, rhs);
+    }
+    return nullptr;
+  }
+
+  // && and || only evaluate the right operand when it decides the result
+  llvm::Value* SonicCodegen::generate_logical(ast::Expression* expr, bool isAnd) {
+    llvm::BasicBlock* from = builder->GetInsertBlock();
+    if (!from) return nullptr;
+
+    llvm::Value* lhs = toBool(generate_expression(expr->lhs_.get()));
+    if (!lhs) {
+      error(expr->loc_, "operand of '" + expr->value_ + "' cannot be used as bool");
+      return nullptr;
+    }
+    from = builder->GetInsertBlock();
+
+    llvm::Function* fn = from->getParent();
+    auto rhsBlock = llvm::BasicBlock::Create(context, isAnd ? "and.rhs" : "or.rhs", fn);
+    auto end = llvm::BasicBlock::Create(context, isAnd ? "and.end" : "or.end", fn);
+
+    if (isAnd) builder->CreateCondBr(lhs, rhsBlock, end);
+    else builder->CreateCondBr(lhs, end, rhsBlock);
+    ssa_.sealBlock(rhsBlock);
+
+    builder->SetInsertPoint(rhsBlock);
+    llvm::Value* rhs = toBool(generate_expression(expr->rhs_.get()));
+    if (!rhs) {
+      error(expr->loc_, "operand of '" + expr->value_ + "' cannot be used as bool");
+      rhs = llvm::PoisonValue::get(builder->getInt1Ty());
+    }
+    llvm::BasicBlock* rhsEnd = builder->GetInsertBlock();
+    builder->CreateBr(end);
+    ssa_.sealBlock(end);
+
+    builder->SetInsertPoint(end);
+    llvm::PHINode* phi = builder->CreatePHI(builder->getInt1Ty(), 2);
+    phi->addIncoming(builder->getInt1(!isAnd), from);
+    phi->addIncoming(rhs, rhsEnd);
+    return phi;
+  }
+
+  // `base ** exp`: a square-and-multiply chain for constant integer
+  // exponents, llvm.powi for other integer exponents and llvm.pow for
+  // floating point ones. Integer bases without a constant exponent go
+  // through double.
+  llvm::Value* SonicCodegen::generate_power(llvm::Value* base, llvm::Value* exp) {
+    llvm::Type* type = base->getType();
+    bool fp = type->isFloatingPointTy();
+    if (!fp && !type->isIntegerTy()) return nullptr;
+
+    if (auto constant = llvm::dyn_cast<llvm::ConstantInt>(exp)) {
+      int64_t n = constant->getSExtValue();
+      uint64_t e = n < 0 ? 0 - static_cast<uint64_t>(n) : static_cast<uint64_t>(n);
+
+      auto mul = [&](llvm::Value* a, llvm::Value* b) {
+        return fp ? builder->CreateFMul(a, b) : builder->CreateMul(a, b, "", false, true);
+      };
+
+      llvm::Value* result = nullptr;
+      llvm::Value* square = base;
+      for (; e; e >>= 1) {
+        if (e & 1) result = result ? mul(result, square) : square;
+        if (e > 1) square = mul(square, square);
+      }
+
+      llvm::Constant* one = fp ? llvm::ConstantFP::get(type, 1.0) : llvm::ConstantInt::get(type, 1);
+      if (!result) return one;
+      if (n < 0) return fp ? builder->CreateFDiv(one, result) : builder->CreateSDiv(one, result);
+      return result;
+    }
+
+    llvm::Value* value = fp ? base : builder->CreateSIToFP(base, builder->getDoubleTy());
+    if (exp->getType()->isIntegerTy()) {
+      exp = builder->CreateSExtOrTrunc(exp, builder->getInt32Ty());
+      value = builder->CreateIntrinsic(llvm::Intrinsic::powi, {value->getType(), exp->getType()}, {value, exp});
+    } else if (exp->getType()->isFloatingPointTy()) {
+      exp = coerce(exp, value->getType());
+      value = builder->CreateIntrinsic(llvm::Intrinsic::pow, {value->getType()}, {value, exp});
+    } else {
+      return nullptr;
+    }
+
+    return fp ? value : builder->CreateFPToSI(value, type);
+  }
+
+  // both operands of an arithmetic or comparison operator in one type:
+  // the wider integer, the wider float, or the float when mixed
+  void SonicCodegen::balance(llvm::Value*& lhs, llvm::Value*& rhs) {
+    llvm::Type* l = lhs->getType();
+    llvm::Type* r = rhs->getType();
+    if (l == r) return;
+
+    auto toFloat = [&](llvm::Value* v, llvm::Type* to) {
+      return v->getType()->isIntegerTy(1) ? builder->CreateUIToFP(v, to) : builder->CreateSIToFP(v, to);
+    };
+
+    if (l->isIntegerTy() && r->isIntegerTy()) {
+      if (l->getIntegerBitWidth() < r->getIntegerBitWidth()) lhs = coerce(lhs, r);
+      else rhs = coerce(rhs, l);
+    } else if (l->isFloatingPointTy() && r->isFloatingPointTy()) {
+      if (l->getPrimitiveSizeInBits() < r->getPrimitiveSizeInBits()) lhs = coerce(lhs, r);
+      else rhs = coerce(rhs, l);
+    } else if (l->isFloatingPointTy() && r->isIntegerTy()) {
+      rhs = toFloat(rhs, l);
+    } else if (l->isIntegerTy() && r->isFloatingPointTy()) {
+      lhs = toFloat(lhs, r);
+    }
+  }
+
+  llvm::Value* SonicCodegen::toBool(llvm::Value* value) {
+    if (!value) return nullptr;
+
+    llvm::Type* type = value->getType();
+    if (type->isIntegerTy(1)) return value;
+    if (type->isIntegerTy()) return builder->CreateICmpNE(value, llvm::ConstantInt::get(type, 0));
+    if (type->isFloatingPointTy()) return builder->CreateFCmpUNE(value, llvm::ConstantFP::get(type, 0.0));
+    if (type->isPointerTy()) return builder->CreateIsNotNull(value);
+    return nullptr;
+  }
+
+  llvm::Function* SonicCodegen::declareFunction(Symbol* fnSym) {
+    auto found = functions_.find(fnSym);
+    if (found != functions_.end()) return found->second;
+
+    // a symbol defined in another module (or seen twice) resolves by name
+    if (auto existing = module->getFunction(fnSym->name_)) {
+      functions_[fnSym] = existing;
+      return existing;
+    }
+
+    // Return type
+    llvm::Type* retType = llvm::Type::getVoidTy(context);
+    if (fnSym->type_) retType = mapping_type(fnSym->type_);
+    else {
+      retType = llvm::Type::getVoidTy(context);
+    }
+
+    // Parameter types
+    std::vector<llvm::Type*> paramTypes;
+    for (auto& p : fnSym->params_) {
+      auto t = mapping_type(p);
+      if (!t) {
+        t = llvm::Type::getInt64Ty(context);
+      }
+      paramTypes.push_back(t);
+    }
+
+    if (!retType) {
+      return nullptr;
+    }
+    
+    // Validate all parameter types before creating FunctionType
+    for (size_t i = 0; i < paramTypes.size(); i++) {
+      if (!paramTypes[i]) {
+        paramTypes[i] = llvm::Type::getInt64Ty(context);
+      }
+      // Make sure it's not a FunctionType
+      if (paramTypes[i]->isFunctionTy()) {
+        std::cerr << "Error: parameter " << i << " cannot be a FunctionType for: " << fnSym->name_ << std::endl;
+        paramTypes[i] = llvm::Type::getInt64Ty(context);
+      }
+    }
+    
+    // Return type also cannot be a FunctionType
+    if (retType->isFunctionTy()) {
+      retType = llvm::Type::getVoidTy(context);
+    }
+
+    auto funcType = llvm::FunctionType::get(retType, paramTypes, fnSym->variadic_);
+    if (!funcType) {
+      return nullptr;
+    }
+    
+    auto func = llvm::Function::Create(funcType, (fnSym->public_ || fnSym->extern_ || fnSym->async_) ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage, fnSym->name_, module.get());
+    
+    if (!func) {
+      return nullptr;
+    }
+
+    // a `restrict` pointer is the only way the callee reaches its memory;
+    // plain pointers and references carry no such guarantee in Sonic
+    for (size_t i = 0; i < fnSym->params_.size(); i++) {
+      ast::Type* param = fnSym->params_[i];
+      if (param && param->restrict_ && paramTypes[i]->isPointerTy()) func->addParamAttr(i, llvm::Attribute::NoAlias);
+    }
+
+    functions_[fnSym] = func;
+    return func;
+  }
+
+  llvm::Value* SonicCodegen::valueOf(Symbol* sym) {
+    auto found = values_.find(sym);
+    if (found != values_.end()) return found->second;
+
+    // globals of other modules are declared here and linked by name
+    if (sym->kind_ != SymbolKind::VARIABLE || !sym->parent_ || sym->parent_->kind_ != SymbolKind::NAMESPACE) return nullptr;
+
+    llvm::Type* ty = sym->type_ ? mapping_type(sym->type_) : nullptr;
+    if (!ty || ty->isVoidTy()) ty = llvm::Type::getInt64Ty(context);
+
+    auto gv = module->getGlobalVariable(sym->name_);
+    if (!gv) gv = new llvm::GlobalVariable(*module, ty, false, llvm::GlobalValue::ExternalLinkage, nullptr, sym->name_);
+
+    values_[sym] = gv;
+    return gv;
+  }
+
+  // one private unnamed_addr constant per distinct literal of the module;
+  // without interior NULs the target places it in a mergeable string
+  // section (.rodata.str1.1, __cstring), where the linker dedupes equal
+  // literals across modules
+  llvm::Constant* SonicCodegen::stringLiteral(const std::string& value) {
+    auto found = strings_.find(value);
+    if (found != strings_.end()) return found->second;
+
+    auto init = llvm::ConstantDataArray::getString(context, value, true);
+    auto gv = new llvm::GlobalVariable(*module, init->getType(), true, llvm::GlobalValue::PrivateLinkage, init, ".str");
+    gv->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    gv->setAlignment(llvm::Align(1));
+
+    strings_.emplace(value, gv);
+    return gv;
+  }
+
+  void SonicCodegen::defineLocal(Symbol* sym, const std::string& name, llvm::Type* type, llvm::Value* init, const SourceLocation& loc, unsigned argNo) {
+    llvm::DILocalVariable* variable = debug_ ? debug_->createVariable(name, loc, argNo, type) : nullptr;
+
+    // scalars that are only read and written by name become SSA values
+    bool scalar = type->isIntegerTy() || type->isFloatingPointTy() || type->isPointerTy();
+    if (sym && scalar && !address_taken_.count(sym)) {
+      ssa_.declare(sym, type);
+      ssa_.writeVariable(sym, builder->GetInsertBlock(), init);
+      if (variable) {
+        debug_variables_[sym] = variable;
+        debug_->describeValue(*builder, init, variable, loc);
+      }
+      return;
+    }
+
+    llvm::Function* f = builder->GetInsertBlock()->getParent();
+    llvm::IRBuilder<> entryBuilder(&f->getEntryBlock(), f->getEntryBlock().begin());
+    llvm::AllocaInst* alloca = entryBuilder.CreateAlloca(type, nullptr, name + "_addr");
+    if (debug_) debug_->declareVariable(*builder, alloca, variable, loc);
+
+    // stack coloring only runs when optimizing
+    if (!scopes_.empty() && cfg::optimizer_level != cfg::OptLevel::NO) {
+      builder->CreateLifetimeStart(alloca);
+      scopes_.back().push_back(alloca);
+    }
+    store(init, alloca, sym ? sym->type_ : nullptr);
+    if (sym) values_[sym] = alloca;
+  }
+
+  void SonicCodegen::assignVariable(Symbol* sym, llvm::Value* value, const SourceLocation& loc) {
+    if (auto type = ssa_.typeOf(sym)) {
+      value = coerce(value, type);
+      ssa_.writeVariable(sym, builder->GetInsertBlock(), value);
+      auto variable = debug_variables_.find(sym);
+      if (variable != debug_variables_.end()) debug_->describeValue(*builder, value, variable->second, loc);
+      return;
+    }
+
+    llvm::Value* storage = valueOf(sym);
+    if (auto ai = llvm::dyn_cast_or_null<llvm::AllocaInst>(storage)) {
+      store(coerce(value, ai->getAllocatedType()), ai, sym->type_);
+    } else if (auto gv = llvm::dyn_cast_or_null<llvm::GlobalVariable>(storage)) {
+      store(coerce(value, gv->getValueType()), gv, sym->type_);
+    }
+  }
+
+  // address of `*p` or `p[i]`; pointers are opaque in the IR, so the
+  // element type comes from the Sonic type of the pointer
+  llvm::Value* SonicCodegen::elementAddress(ast::Expression* expr, ast::Type*& element) {
+    ast::Type* pointer = expr->nested_ ? expr->nested_->type_ : nullptr;
+    if (!pointer || (pointer->kind_ != ast::TypeKind::PTR && pointer->kind_ != ast::TypeKind::REF) || !pointer->nested_) return nullptr;
+
+    element = pointer->nested_.get();
+    llvm::Type* elementType = mapping_type(element);
+    if (elementType->isVoidTy()) return nullptr;
+
+    llvm::Value* base = generate_expression(expr->nested_.get());
+    if (!base || !base->getType()->isPointerTy()) return nullptr;
+    if (expr->kind_ == ast::ExprKind::DEREF) return base;
+
+    llvm::Value* index = generate_expression(expr->index_.get());
+    if (!index || !index->getType()->isIntegerTy()) return nullptr;
+
+    index = builder->CreateSExtOrTrunc(index, module->getDataLayout().getIndexType(base->getType()));
+    return builder->CreateInBoundsGEP(elementType, base, index);
+  }
+
+  llvm::LoadInst* SonicCodegen::load(llvm::Type* type, llvm::Value* address, ast::Type* sonicType) {
+    llvm::LoadInst* value = builder->CreateLoad(type, address);
+    if (tbaa_) tbaa_->attach(value, sonicType);
+    return value;
+  }
+
+  void SonicCodegen::store(llvm::Value* value, llvm::Value* address, ast::Type* sonicType) {
+    llvm::StoreInst* access = builder->CreateStore(value, address);
+    if (tbaa_) tbaa_->attach(access, sonicType);
+  }
+
+  // integer width and float precision changes between a value and the
+  // variable it is stored in; anything else is left to the verifier
+  llvm::Value* SonicCodegen::coerce(llvm::Value* value, llvm::Type* type) {
+    llvm::Type* from = value->getType();
+    if (from == type) return value;
+
+    if (from->isIntegerTy() && type->isIntegerTy()) {
+      if (from->isIntegerTy(1)) return builder->CreateZExtOrTrunc(value, type);
+      return builder->CreateSExtOrTrunc(value, type);
+    }
+    if (from->isFloatingPointTy() && type->isFloatingPointTy()) return builder->CreateFPCast(value, type);
+    return value;
+  }
+
   llvm::Type* SonicCodegen::mapping_type(ast::Type* type) {
     if (!type) return llvm::Type::getVoidTy(context);
 
@@ -518,4 +1151,38 @@ namespace sonic::backend {
     }
   }
 
+  bool generate_modules(Symbol* symbols, const std::vector<ast::Program*>& programs, const BuildTarget& build, ObjectStore* store, const std::string& interface, unsigned jobs, std::vector<std::string>& result) {
+    // threads left over when there are fewer modules than jobs go to the
+    // split backend of each module
+    unsigned workers = std::max(1u, std::min<unsigned>(jobs, programs.size()));
+    unsigned split = std::max(1u, jobs / workers);
+
+    std::vector<std::vector<std::string>> objects(programs.size());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+
+    auto worker = [&] {
+      for (size_t i = next++; i < programs.size(); i = next++) {
+        SonicCodegen codegen(symbols, build);
+        codegen.split_jobs = split;
+        codegen.object_store = store;
+        codegen.interface_key = interface;
+        if (!codegen.generate(programs[i])) failed = true;
+        objects[i] = codegen.objects();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < workers; t++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+
+    if (store && cfg::cache_stats) {
+      std::cerr << "object cache: " << store->hits() << " hits, " << store->misses() << " misses\n";
+    }
+
+    // in module order, independent of which thread finished first
+    for (auto& list : objects) result.insert(result.end(), list.begin(), list.end());
+    return !failed;
+  }
 };
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
 
@@ -21,31 +29,116 @@
 #include <llvm/TargetParser/Host.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/CodeGen.h>
 
 #include "ast.h"
+#include "backend_session.h"
+#include "debug_info.h"
+#include "object_cache.h"
+#include "optimizer.h"
+#include "ssa_builder.h"
 #include "symbol.h"
+#include "type_alias.h"
 
 using namespace sonic::frontend;
 
 namespace sonic::backend {
   class SonicCodegen {
     public:
-    SonicCodegen(Symbol* symbol);
+    SonicCodegen(Symbol* symbol, const BuildTarget& build = default_build_target());
     ~SonicCodegen();
 
-    void generate(ast::Program* program);
+    // false if the module could not be compiled; nothing is cached then
+    bool generate(ast::Program* program);
+    // IR only, optimized but not emitted; see takeModule()
+    bool generateIR(ast::Program* program);
+    // hands the module and its context over (to the JIT); the codegen
+    // cannot be used afterwards
+    llvm::orc::ThreadSafeModule takeModule();
     void saveBitcode(const std::string& path);
     void saveLLReadable(const std::string& path);
+    bool emitFile(const std::string& path, llvm::CodeGenFileType type);
+    bool emitSplitObjects(const std::string& path);
+    // pre-linked bitcode for --lto, with a summary index for thin
+    bool emitLtoBitcode(const std::string& path);
     void generate_statement(ast::Statement* stmt);
+    void generate_block(std::vector<std::unique_ptr<ast::Statement>>& body);
     llvm::Value* generate_expression(ast::Expression* expr);
+    llvm::Value* generate_binary(ast::Expression* expr);
+    llvm::Value* generate_logical(ast::Expression* expr, bool isAnd);
+    llvm::Value* generate_power(llvm::Value* base, llvm::Value* exp);
     llvm::Type* mapping_type(ast::Type* type);
 
+    // object files (bitcode with --lto) written by generate(), in link order
+    const std::vector<std::string>& objects() const { return objects_; }
+
+    // threads used to split this module's backend (see split_codegen.h)
+    unsigned split_jobs = 1;
+    // compiled objects shared by all codegen threads, null to always compile
+    ObjectStore* object_store = nullptr;
+    // ObjectStore::interfaceOf() of the project, part of the source key
+    std::string interface_key;
+
     private:
-    llvm::LLVMContext context;
+    // owned until takeModule()
+    std::unique_ptr<llvm::LLVMContext> owned_context;
+    llvm::LLVMContext& context;
     std::unique_ptr<llvm::Module> module;
     std::unique_ptr<llvm::IRBuilder<>> builder;
 
+    TargetKey target;
+    // build/ or build/<triple>/, the module's cache goes to <dir>/cache
+    std::string build_dir_;
+    // owned by BackendSession, shared by the modules of one thread
     llvm::TargetMachine* targetMachine = nullptr;
+    std::unique_ptr<Optimizer> optimizer;
+    // set with -g / -gline-tables-only
+    std::unique_ptr<DebugInfo> debug_;
+    // TBAA tags on loads and stores, only when optimizing
+    std::unique_ptr<TypeAliasInfo> tbaa_;
+
+    // keys of this module in object_store (by IR and by cached AST), and
+    // what was compiled for it
+    std::string object_key_;
+    std::string source_key_;
+    std::vector<std::string> emitted_;
+
+    // false if a statement could not be lowered, see error()
+    bool lower(ast::Program* program);
+    void error(const SourceLocation& loc, const std::string& message);
+    bool failed_ = false;
+    bool writeObject(const std::string& output_file, std::string_view object);
+    bool loadCachedObjects(const std::string& path, const std::string& key);
+
+    // LLVM values of this module only; symbols are shared between the
+    // codegen threads and are not written to
+    std::unordered_map<Symbol*, llvm::Value*> values_;
+    std::unordered_map<Symbol*, llvm::Function*> functions_;
+    // string literals of this module, see stringLiteral()
+    std::unordered_map<std::string, llvm::GlobalVariable*> strings_;
+    // functions marked @multiversion, with the requested ISA levels
+    std::vector<std::pair<llvm::Function*, std::vector<std::string>>> multiversioned_;
+    std::vector<std::string> objects_;
+
+    // locals of the function being generated: scalars live in ssa_,
+    // anything whose address is taken in an alloca of values_
+    SSABuilder ssa_;
+    std::unordered_set<Symbol*> address_taken_;
+    std::unordered_map<Symbol*, llvm::DILocalVariable*> debug_variables_;
+    // allocas declared in each open `if` / `while` body, see generate_block()
+    std::vector<std::vector<llvm::AllocaInst*>> scopes_;
+
+    llvm::Function* declareFunction(Symbol* fnSym);
+    llvm::Value* valueOf(Symbol* sym);
+    void defineLocal(Symbol* sym, const std::string& name, llvm::Type* type, llvm::Value* init, const SourceLocation& loc, unsigned argNo);
+    void assignVariable(Symbol* sym, llvm::Value* value, const SourceLocation& loc);
+    llvm::Value* elementAddress(ast::Expression* expr, ast::Type*& element);
+    llvm::LoadInst* load(llvm::Type* type, llvm::Value* address, ast::Type* sonicType);
+    void store(llvm::Value* value, llvm::Value* address, ast::Type* sonicType);
+    llvm::Value* coerce(llvm::Value* value, llvm::Type* type);
+    void balance(llvm::Value*& lhs, llvm::Value*& rhs);
+    llvm::Value* toBool(llvm::Value* value);
+    llvm::Constant* stringLiteral(const std::string& value);
 
     std::string current_file_output;
     Symbol* symbols;
@@ -58,4 +151,10 @@ namespace sonic::backend {
       return entry;
     }
   };
+
+  // generates every program for `build` on up to `jobs` threads, one
+  // SonicCodegen (and LLVMContext) per module; fills `result` with the
+  // objects in program order and returns false if any module failed.
+  // `store` is the target's object cache, or null.
+  bool generate_modules(Symbol* symbols, const std::vector<ast::Program*>& programs, const BuildTarget& build, ObjectStore* store, const std::string& interface, unsigned jobs, std::vector<std::string>& result);
 };
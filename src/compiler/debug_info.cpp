@@ -0,0 +1,96 @@
+#include "debug_info.h"
+
+#include <vector>
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DebugInfo.h>
+#include <llvm/TargetParser/Triple.h>
+
+namespace sonic::backend {
+  DebugInfo::DebugInfo(llvm::Module& module, const std::string& file, const std::string& directory, bool lineTablesOnly)
+  : builder_(module), lineTablesOnly_(lineTablesOnly) {
+    pointerBits_ = module.getDataLayout().getPointerSizeInBits();
+    file_ = builder_.createFile(file, directory);
+
+    // no DWARF language code of our own yet; C is what debuggers and perf
+    // fall back to for plain symbols anyway
+    unit_ = builder_.createCompileUnit(
+      llvm::dwarf::DW_LANG_C, file_, "sonic", false, "", 0, "",
+      lineTablesOnly ? llvm::DICompileUnit::LineTablesOnly : llvm::DICompileUnit::FullDebug);
+
+    module.addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    if (module.getTargetTriple().isOSWindows()) {
+      module.addModuleFlag(llvm::Module::Warning, "CodeView", 1);
+    } else {
+      module.addModuleFlag(llvm::Module::Max, "Dwarf Version", 5);
+    }
+  }
+
+  llvm::DIType* DebugInfo::typeOf(llvm::Type* type) {
+    if (type->isIntegerTy(1)) return builder_.createBasicType("bool", 8, llvm::dwarf::DW_ATE_boolean);
+    if (type->isIntegerTy()) {
+      unsigned bits = type->getIntegerBitWidth();
+      return builder_.createBasicType("i" + std::to_string(bits), bits, llvm::dwarf::DW_ATE_signed);
+    }
+    if (type->isFloatTy()) return builder_.createBasicType("f32", 32, llvm::dwarf::DW_ATE_float);
+    if (type->isDoubleTy()) return builder_.createBasicType("f64", 64, llvm::dwarf::DW_ATE_float);
+    // opaque pointers carry no pointee, describe them as untyped addresses
+    if (type->isPointerTy()) return builder_.createPointerType(nullptr, pointerBits_);
+    return nullptr;
+  }
+
+  void DebugInfo::beginFunction(llvm::Function* fn, const std::string& name, const SourceLocation& loc) {
+    llvm::DISubroutineType* type;
+    if (lineTablesOnly_) {
+      type = builder_.createSubroutineType(builder_.getOrCreateTypeArray({}));
+    } else {
+      // return type first, then the parameters; null stands for void
+      std::vector<llvm::Metadata*> types = {typeOf(fn->getReturnType())};
+      for (auto& arg : fn->args()) types.push_back(typeOf(arg.getType()));
+      type = builder_.createSubroutineType(builder_.getOrCreateTypeArray(types));
+    }
+
+    auto flags = llvm::DISubprogram::SPFlagDefinition;
+    if (fn->hasLocalLinkage()) flags |= llvm::DISubprogram::SPFlagLocalToUnit;
+
+    function_ = builder_.createFunction(
+      file_, name, fn->getName(), file_, loc.line, type, loc.line,
+      llvm::DINode::FlagPrototyped, flags);
+    fn->setSubprogram(function_);
+  }
+
+  void DebugInfo::endFunction() {
+    if (function_) builder_.finalizeSubprogram(function_);
+    function_ = nullptr;
+  }
+
+  llvm::DILocation* DebugInfo::location(const SourceLocation& loc) const {
+    if (!function_) return nullptr;
+    return llvm::DILocation::get(function_->getContext(), loc.line, loc.column, function_);
+  }
+
+  llvm::DILocalVariable* DebugInfo::createVariable(const std::string& name, const SourceLocation& loc, unsigned argNo, llvm::Type* type) {
+    if (lineTablesOnly_ || !function_) return nullptr;
+
+    llvm::DIType* diType = typeOf(type);
+    if (!diType) return nullptr;
+
+    return argNo
+      ? builder_.createParameterVariable(function_, name, argNo, file_, loc.line, diType, true)
+      : builder_.createAutoVariable(function_, name, file_, loc.line, diType, true);
+  }
+
+  void DebugInfo::declareVariable(llvm::IRBuilder<>& builder, llvm::AllocaInst* storage, llvm::DILocalVariable* variable, const SourceLocation& loc) {
+    if (!variable) return;
+    builder_.insertDeclare(storage, variable, builder_.createExpression(), location(loc), builder.GetInsertBlock());
+  }
+
+  void DebugInfo::describeValue(llvm::IRBuilder<>& builder, llvm::Value* value, llvm::DILocalVariable* variable, const SourceLocation& loc) {
+    if (!variable || !value) return;
+    builder_.insertDbgValueIntrinsic(value, variable, builder_.createExpression(), location(loc), builder.GetInsertBlock());
+  }
+
+  void DebugInfo::finalize() {
+    builder_.finalize();
+  }
+};
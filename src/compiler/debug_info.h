@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+
+#include "source.h"
+
+namespace sonic::backend {
+  // debug metadata for one module, built from the SourceLocation of each
+  // AST node. Line tables only (-gline-tables-only) costs one DILocation
+  // per statement and a type-less DISubprogram per function, cheap enough
+  // for optimized builds; -g adds parameter and local variable records.
+  class DebugInfo {
+    public:
+    DebugInfo(llvm::Module& module, const std::string& file, const std::string& directory, bool lineTablesOnly);
+
+    // attaches a DISubprogram to `fn`; statements after this are placed in it
+    void beginFunction(llvm::Function* fn, const std::string& name, const SourceLocation& loc);
+    void endFunction();
+
+    // location inside the current function, null outside of one
+    llvm::DILocation* location(const SourceLocation& loc) const;
+
+    // record of a parameter (argNo from 1) or local (argNo 0) of the
+    // current function; null for line tables
+    llvm::DILocalVariable* createVariable(const std::string& name, const SourceLocation& loc, unsigned argNo, llvm::Type* type);
+
+    // dbg.declare for a variable kept in memory, dbg.value for each new
+    // value of a variable kept in registers; no-op for a null variable
+    void declareVariable(llvm::IRBuilder<>& builder, llvm::AllocaInst* storage, llvm::DILocalVariable* variable, const SourceLocation& loc);
+    void describeValue(llvm::IRBuilder<>& builder, llvm::Value* value, llvm::DILocalVariable* variable, const SourceLocation& loc);
+
+    // resolves forward references; call once the module is complete
+    void finalize();
+
+    private:
+    llvm::DIBuilder builder_;
+    llvm::DICompileUnit* unit_ = nullptr;
+    llvm::DIFile* file_ = nullptr;
+    llvm::DISubprogram* function_ = nullptr;
+    bool lineTablesOnly_;
+    unsigned pointerBits_ = 64;
+
+    llvm::DIType* typeOf(llvm::Type* type);
+  };
+};
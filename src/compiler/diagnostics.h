@@ -72,20 +72,34 @@ public:
     diagnostics.push_back(diagnostic);
   }
 
-  void flush() const {
-    for (const auto& d : diagnostics) {
-      printOne(d);
-    }
+  // prints and forgets what was reported; exits only on errors, warnings
+  // leave the build running
+  void flush() {
+    print();
 
-    if (!diagnostics.empty()) {
+    if (has_errors()) {
       std::exit(1);
     }
+    diagnostics.clear();
+  }
+
+  // like flush(), but leaves the process running
+  void print() const {
+    for (const auto& d : diagnostics) {
+      printOne(d);
+    }
   }
 
   int size() const {
     return diagnostics.size();
   }
 
+  bool has_errors() const {
+    return std::any_of(diagnostics.begin(), diagnostics.end(), [](const Diagnostic& d) {
+      return d.severity == Severity::ERROR;
+    });
+  }
+
 private:
   std::vector<Diagnostic> diagnostics;
 
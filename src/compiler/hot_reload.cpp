@@ -0,0 +1,201 @@
+#include "hot_reload.h"
+#include "codegen.h"
+#include "jit.h"
+#include "../core/config.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+namespace cfg = sonic::config;
+namespace fs = std::filesystem;
+
+namespace sonic::backend {
+  namespace {
+    using Clock = std::chrono::steady_clock;
+
+    std::map<std::string, fs::file_time_type> scan_sources(const std::string& root) {
+      std::map<std::string, fs::file_time_type> files;
+      std::error_code ec;
+      for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->path().extension() != ".sn") continue;
+        files[it->path().string()] = it->last_write_time(ec);
+      }
+      return files;
+    }
+
+    class HotSession {
+      public:
+      HotSession(llvm::orc::LLLazyJIT& jit) : jit_(jit) {
+        stubs_ = llvm::orc::createLocalIndirectStubsManagerBuilder(jit.getTargetTriple())();
+      }
+
+      bool valid() const { return stubs_ != nullptr; }
+      bool mainReturnsValue() const { return main_returns_value_; }
+
+      // generates every program, adds the functions that changed since the
+      // last load and points their stubs at the new bodies
+      llvm::Error load(Symbol* symbols, const std::vector<ast::Program*>& programs, size_t& changed);
+
+      private:
+      llvm::orc::LLLazyJIT& jit_;
+      std::unique_ptr<llvm::orc::IndirectStubsManager> stubs_;
+      unsigned generation_ = 0;
+      bool main_returns_value_ = false;
+
+      std::unordered_map<std::string, uint64_t> hashes_;   // stub -> body IR hash
+      std::set<std::string> globals_;                      // defined globals
+
+      void prepare(llvm::Module& module, std::vector<std::pair<std::string, std::string>>& bodies);
+    };
+
+    // Every defined function `f` becomes a body `f$<generation>` plus a stub
+    // named `f`; all calls, including those within the module, go through
+    // the stub. Unchanged bodies are dropped from reloaded modules.
+    void HotSession::prepare(llvm::Module& module, std::vector<std::pair<std::string, std::string>>& bodies) {
+      std::vector<llvm::Function*> defined;
+      for (auto& fn : module) {
+        if (!fn.isDeclaration()) defined.push_back(&fn);
+      }
+
+      for (auto* fn : defined) {
+        std::string name = fn->getName().str();
+        std::string stub = fn->hasLocalLinkage() ? module.getModuleIdentifier() + "." + name : name;
+
+        if (name == "main") main_returns_value_ = fn->getReturnType()->isIntegerTy();
+
+        std::string ir;
+        llvm::raw_string_ostream os(ir);
+        fn->print(os);
+        uint64_t hash = llvm::xxh3_64bits(llvm::arrayRefFromStringRef(os.str()));
+
+        auto previous = hashes_.find(stub);
+        bool changed = previous == hashes_.end() || previous->second != hash;
+
+        fn->setName(stub + "$" + std::to_string(generation_));
+        auto decl = llvm::Function::Create(fn->getFunctionType(), llvm::Function::ExternalLinkage, stub, module);
+        fn->replaceAllUsesWith(decl);
+
+        if (!changed) {
+          fn->eraseFromParent();
+          continue;
+        }
+
+        fn->setLinkage(llvm::Function::ExternalLinkage);
+        hashes_[stub] = hash;
+        bodies.emplace_back(stub, fn->getName().str());
+      }
+
+      for (auto& gv : module.globals()) {
+        if (gv.isDeclaration() || gv.hasLocalLinkage()) continue;
+
+        std::string name = gv.getName().str();
+        if (globals_.insert(name).second) continue;
+
+        // already running with its own value
+        gv.setInitializer(nullptr);
+        gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+      }
+    }
+
+    llvm::Error HotSession::load(Symbol* symbols, const std::vector<ast::Program*>& programs, size_t& changed) {
+      std::vector<std::pair<std::string, std::string>> bodies;
+
+      for (auto& program : programs) {
+        SonicCodegen codegen(symbols);
+        if (!codegen.generateIR(program)) return llvm::createStringError(llvm::inconvertibleErrorCode(), "invalid IR in '" + program->name_ + "'");
+
+        auto tsm = codegen.takeModule();
+        size_t before = bodies.size();
+        tsm.withModuleDo([&](llvm::Module& m) { prepare(m, bodies); });
+
+        // nothing new in this module
+        if (bodies.size() == before && generation_ > 0) continue;
+
+        if (auto err = jit_.addLazyIRModule(std::move(tsm))) return err;
+      }
+
+      // stubs are defined before any body is looked up, bodies call them
+      llvm::orc::SymbolMap created;
+      for (auto& [stub, body] : bodies) {
+        if (stubs_->findStub(stub, false).getAddress()) continue;
+        if (auto err = stubs_->createStub(stub, llvm::orc::ExecutorAddr(), llvm::JITSymbolFlags::Exported)) return err;
+        created[jit_.mangleAndIntern(stub)] = stubs_->findStub(stub, false);
+      }
+      if (!created.empty()) {
+        if (auto err = jit_.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(created)))) return err;
+      }
+
+      for (auto& [stub, body] : bodies) {
+        auto address = jit_.lookup(body);
+        if (!address) return address.takeError();
+        if (auto err = stubs_->updatePointer(stub, *address)) return err;
+      }
+
+      changed = bodies.size();
+      generation_++;
+      return llvm::Error::success();
+    }
+  }
+
+  int run_hot(Symbol* symbols, const std::vector<ast::Program*>& programs, HotFrontend frontend) {
+    TargetKey key = default_target_key();
+
+    auto jit = create_jit(key, nullptr);
+    if (!jit) return report_error(jit.takeError());
+
+    HotSession session(**jit);
+    if (!session.valid()) {
+      std::cerr << "\033[31merror:\033[0m hot reload is not supported for '" << key.triple << "'\n";
+      return 1;
+    }
+
+    size_t changed = 0;
+    if (auto err = session.load(symbols, programs, changed)) return report_error(std::move(err));
+
+    auto entry = (*jit)->lookup("main");
+    if (!entry) return report_error(entry.takeError());
+
+    std::atomic<bool> done{false};
+    int status = 0;
+    std::thread runner([&] {
+      status = call_main(*entry, session.mainReturnsValue());
+      done = true;
+    });
+
+    auto sources = scan_sources(cfg::project_root);
+    while (!done) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+      auto current = scan_sources(cfg::project_root);
+      if (current == sources) continue;
+      sources = std::move(current);
+
+      auto start = Clock::now();
+
+      std::vector<ast::Program*> reloaded;
+      if (!frontend(symbols, reloaded)) continue;
+
+      if (auto err = session.load(symbols, reloaded, changed)) {
+        report_error(std::move(err));
+        continue;
+      }
+
+      double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      std::cerr << "\033[32mhot reload:\033[0m " << changed << " function(s) swapped in " << ms << " ms\n";
+    }
+
+    runner.join();
+    return status;
+  }
+};
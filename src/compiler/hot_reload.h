@@ -0,0 +1,22 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "ast.h"
+#include "symbol.h"
+
+using namespace sonic::frontend;
+
+namespace sonic::backend {
+  // re-runs the frontend over the whole project; false when it reported
+  // diagnostics, in which case the running code is left as it is
+  using HotFrontend = std::function<bool(Symbol*& symbols, std::vector<ast::Program*>& programs)>;
+
+  // `sonic run --hot`: main runs on its own thread while the project's .sn
+  // files are polled. On a change the frontend runs again and only the
+  // functions whose IR changed are compiled, then swapped in through
+  // indirect stubs. Globals keep their state: after the first load their
+  // definitions become declarations of the running ones.
+  int run_hot(Symbol* symbols, const std::vector<ast::Program*>& programs, HotFrontend frontend);
+};
@@ -0,0 +1,126 @@
+#include "jit.h"
+#include "backend_session.h"
+#include "codegen.h"
+#include "optimizer.h"
+#include "../core/config.h"
+
+#include <iostream>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/Support/Error.h>
+#include <llvm/TargetParser/Host.h>
+
+namespace cfg = sonic::config;
+
+namespace sonic::backend {
+  int report_error(llvm::Error error) {
+    std::cerr << "\033[31merror:\033[0m " << llvm::toString(std::move(error)) << "\n";
+    return 1;
+  }
+
+  // SimpleCompiler only tells the cache about objects that compiled; a
+  // failed module's pending key is dropped here
+  class CachingCompiler : public llvm::orc::IRCompileLayer::IRCompiler {
+    public:
+    CachingCompiler(std::unique_ptr<llvm::orc::TMOwningSimpleCompiler> compiler, JitObjectCache* cache)
+    : IRCompiler(compiler->getManglingOptions()), compiler_(std::move(compiler)), cache_(cache) {}
+
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(llvm::Module& module) override {
+      auto object = (*compiler_)(module);
+      if (!object && cache_) cache_->discard(&module);
+      return object;
+    }
+
+    private:
+    std::unique_ptr<llvm::orc::TMOwningSimpleCompiler> compiler_;
+    JitObjectCache* cache_;
+  };
+
+  llvm::Expected<std::unique_ptr<llvm::orc::LLLazyJIT>> create_jit(const TargetKey& key, JitObjectCache* cache) {
+    if (key.triple != llvm::sys::getProcessTriple() && key.triple != llvm::sys::getDefaultTargetTriple()) {
+      return llvm::createStringError(llvm::inconvertibleErrorCode(), "cannot run a program built for '" + key.triple + "' on this host");
+    }
+
+    std::string error;
+    if (!BackendSession::get().initializeTarget(llvm::Triple(key.triple), error)) {
+      return llvm::createStringError(llvm::inconvertibleErrorCode(), error);
+    }
+
+    llvm::orc::JITTargetMachineBuilder jtmb{llvm::Triple(key.triple)};
+    jtmb.setCPU(key.cpu);
+    jtmb.addFeatures(feature_list(key.features));
+    jtmb.setCodeGenOptLevel(codegen_opt_level(cfg::optimizer_level));
+    jtmb.getOptions().EnableFastISel = cfg::optimizer_level == cfg::OptLevel::NO;
+
+    auto jit = llvm::orc::LLLazyJITBuilder()
+      .setJITTargetMachineBuilder(std::move(jtmb))
+      .setCompileFunctionCreator([cache](llvm::orc::JITTargetMachineBuilder builder)
+          -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+        auto machine = builder.createTargetMachine();
+        if (!machine) return machine.takeError();
+        auto compiler = std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*machine), cache);
+        return std::make_unique<CachingCompiler>(std::move(compiler), cache);
+      })
+      .create();
+    if (!jit) return jit.takeError();
+
+    auto& dylib = (*jit)->getMainJITDylib();
+    auto host = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+    if (!host) return host.takeError();
+    dylib.addGenerator(std::move(*host));
+
+    return jit;
+  }
+
+  int call_main(llvm::orc::ExecutorAddr entry, bool returnsValue) {
+    // Sonic ints are i64, the process exit code keeps the low bits
+    if (returnsValue) {
+      auto fn = entry.toPtr<long long (*)()>();
+      return static_cast<int>(fn());
+    }
+
+    auto fn = entry.toPtr<void (*)()>();
+    fn();
+    return 0;
+  }
+
+  int run_jit(Symbol* symbols, const std::vector<ast::Program*>& programs) {
+    TargetKey key = default_target_key();
+
+    std::unique_ptr<JitObjectCache> cache;
+    if (cfg::jit_cache) {
+      cache = std::make_unique<JitObjectCache>(cfg::project_build + "/cache/jit", key, cfg::jit_cache_limit);
+    }
+
+    auto jit = create_jit(key, cache.get());
+    if (!jit) return report_error(jit.takeError());
+
+    bool mainReturnsValue = false;
+    for (auto& program : programs) {
+      SonicCodegen codegen(symbols);
+      if (!codegen.generateIR(program)) return 1;
+
+      auto tsm = codegen.takeModule();
+      tsm.withModuleDo([&](llvm::Module& m) {
+        if (auto fn = m.getFunction("main"); fn && !fn->isDeclaration()) {
+          mainReturnsValue = fn->getReturnType()->isIntegerTy();
+        }
+      });
+
+      if (auto err = (*jit)->addLazyIRModule(std::move(tsm))) return report_error(std::move(err));
+    }
+
+    auto entry = (*jit)->lookup("main");
+    if (!entry) return report_error(entry.takeError());
+
+    int status = call_main(*entry, mainReturnsValue);
+
+    if (cache && cfg::cache_stats) {
+      std::cerr << "jit cache: " << cache->hits() << " hits, " << cache->misses() << " misses\n";
+    }
+
+    return status;
+  }
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include "ast.h"
+#include "backend_session.h"
+#include "jit_cache.h"
+#include "symbol.h"
+
+using namespace sonic::frontend;
+
+namespace sonic::backend {
+  // runs the analyzed programs in-process through ORC's LLLazyJIT: every
+  // function is compiled on its first call, host symbols (libc, the
+  // runtime) resolve against the running process. Returns main's exit
+  // code, or 1 when the program could not be started.
+  int run_jit(Symbol* symbols, const std::vector<ast::Program*>& programs);
+
+  // LLLazyJIT for `key`, which has to be the host; `cache` may be null
+  llvm::Expected<std::unique_ptr<llvm::orc::LLLazyJIT>> create_jit(const TargetKey& key, JitObjectCache* cache);
+
+  // calls a JITed main, returning its value as the exit code
+  int call_main(llvm::orc::ExecutorAddr entry, bool returnsValue);
+
+  int report_error(llvm::Error error);
+};
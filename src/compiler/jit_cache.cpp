@@ -0,0 +1,60 @@
+#include "jit_cache.h"
+#include "profile.h"
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/BLAKE3.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace sonic::backend {
+  JitObjectCache::JitObjectCache(const std::string& dir, const TargetKey& target, uint64_t limit)
+  : store_(dir, limit) {
+    target_ = target.triple + "\n" + target.cpu + "\n" + target.features + "\n"
+      + pipeline_fingerprint() + "\n" LLVM_VERSION_STRING;
+    store_.trim();
+  }
+
+  std::string JitObjectCache::keyFor(const llvm::Module& module) const {
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    llvm::WriteBitcodeToFile(module, os);
+
+    llvm::BLAKE3 hasher;
+    hasher.update(target_);
+    hasher.update(llvm::StringRef(bitcode.data(), bitcode.size()));
+    return llvm::toHex(hasher.final(), true);
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::getObject(const llvm::Module* module) {
+    std::string key = keyFor(*module);
+
+    std::string object;
+    if (store_.load(key, object)) {
+      return llvm::MemoryBuffer::getMemBufferCopy(object, module->getModuleIdentifier());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_[module] = std::move(key);
+    return nullptr;
+  }
+
+  void JitObjectCache::discard(const llvm::Module* module) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(module);
+  }
+
+  void JitObjectCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) {
+    std::string key;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = pending_.find(module);
+      if (it == pending_.end()) return;
+      key = std::move(it->second);
+      pending_.erase(it);
+    }
+
+    store_.store(key, std::string_view(object.getBufferStart(), object.getBufferSize()));
+  }
+};
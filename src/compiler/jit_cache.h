@@ -0,0 +1,41 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "backend_session.h"
+#include "../core/content_store.h"
+
+namespace sonic::backend {
+  // machine code for JIT runs, kept in build/cache/jit/. An entry is keyed
+  // by the module's optimized IR plus everything else that decides the
+  // generated code (triple, CPU, features, opt level, profile, LLVM version).
+  class JitObjectCache : public llvm::ObjectCache {
+    public:
+    JitObjectCache(const std::string& dir, const TargetKey& target, uint64_t limit);
+
+    void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+    // drops the key kept for `module` when its compilation failed
+    void discard(const llvm::Module* module);
+
+    size_t hits() const { return store_.hits(); }
+    size_t misses() const { return store_.misses(); }
+
+    private:
+    sonic::io::ContentStore store_;
+    std::string target_;
+
+    // getObject() sees the IR before codegen passes change it; the key is
+    // kept until notifyObjectCompiled() for the same module
+    std::mutex mutex_;
+    std::unordered_map<const llvm::Module*, std::string> pending_;
+
+    std::string keyFor(const llvm::Module& module) const;
+  };
+};
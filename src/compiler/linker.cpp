@@ -0,0 +1,61 @@
+#include "linker.h"
+#include "../core/config.h"
+
+#include <initializer_list>
+#include <iostream>
+#include <optional>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Program.h>
+#include <llvm/TargetParser/Host.h>
+
+namespace cfg = sonic::config;
+
+namespace sonic::backend {
+  static std::string find_program(std::initializer_list<const char*> names) {
+    for (auto name : names) {
+      if (auto path = llvm::sys::findProgramByName(name)) return *path;
+    }
+    return "";
+  }
+
+  bool link_executable(const std::vector<std::string>& objects, const std::string& output, const std::string& triple) {
+    if (objects.empty()) {
+      std::cerr << "\033[31merror:\033[0m nothing to link for '" << output << "'\n";
+      return false;
+    }
+
+    // only clang can link for another triple from the same driver, and an
+    // instrumented program needs compiler-rt's profile runtime, which only
+    // the clang driver knows where to find
+    bool cross = !triple.empty() && triple != llvm::sys::getDefaultTargetTriple();
+    bool clang_only = cross || cfg::profile_generate;
+    std::string driver = clang_only ? find_program({"clang"}) : find_program({"cc", "clang", "gcc"});
+    if (driver.empty()) {
+      if (cross) std::cerr << "\033[31merror:\033[0m linking for '" << triple << "' needs clang on PATH as the cross linker driver\n";
+      else if (cfg::profile_generate) std::cerr << "\033[31merror:\033[0m --profile-generate needs clang on PATH to link the profile runtime\n";
+      else std::cerr << "\033[31merror:\033[0m no linker driver (cc, clang or gcc) found on PATH\n";
+      return false;
+    }
+
+    std::vector<std::string> args = {driver};
+    if (!find_program({"ld.lld"}).empty()) args.push_back("-fuse-ld=lld");
+    if (cfg::profile_generate) args.push_back("-fprofile-generate");
+    if (cross) args.push_back("--target=" + triple);
+
+    args.push_back("-o");
+    args.push_back(output);
+    args.insert(args.end(), objects.begin(), objects.end());
+
+    std::vector<llvm::StringRef> argv(args.begin(), args.end());
+    std::string error;
+    int status = llvm::sys::ExecuteAndWait(driver, argv, std::nullopt, {}, 0, 0, &error);
+    if (status != 0) {
+      std::cerr << "\033[31merror:\033[0m linking '" << output << "' failed";
+      if (!error.empty()) std::cerr << ": " << error;
+      std::cerr << "\n";
+      return false;
+    }
+
+    return true;
+  }
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sonic::backend {
+  // links `objects` for `triple` into an executable at `output` through
+  // the system C compiler driver on PATH (cc, clang or gcc), using lld
+  // when installed. A cross triple, or --profile-generate (for the profile
+  // runtime), links through clang only
+  bool link_executable(const std::vector<std::string>& objects, const std::string& output, const std::string& triple);
+};
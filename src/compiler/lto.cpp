@@ -0,0 +1,221 @@
+#include "lto.h"
+#include "backend_session.h"
+#include "optimizer.h"
+#include "../core/config.h"
+#include "../core/io.h"
+
+#include <iostream>
+#include <memory>
+#include <set>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+
+namespace cfg = sonic::config;
+
+namespace sonic::backend {
+  static bool report(llvm::Error error) {
+    std::cerr << "\033[31merror:\033[0m " << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+
+  static unsigned lto_opt_level(cfg::OptLevel level) {
+    switch (level) {
+      case cfg::OptLevel::NO: return 0;
+      case cfg::OptLevel::O2: return 2;
+      case cfg::OptLevel::O3:
+      case cfg::OptLevel::OFAST: return 3;
+    }
+    return 2;
+  }
+
+  bool thin_link(const std::vector<std::string>& bitcode, const BuildTarget& build, unsigned jobs, std::vector<std::string>& objects) {
+    const TargetKey& key = build.key;
+    llvm::Triple triple(key.triple);
+
+    std::string error;
+    if (!BackendSession::get().initializeTarget(triple, error)) {
+      std::cerr << "\033[31merror:\033[0m " << error << "\n";
+      return false;
+    }
+
+    llvm::lto::Config conf;
+    conf.DefaultTriple = key.triple;
+    conf.CPU = key.cpu;
+    conf.MAttrs = feature_list(key.features);
+    conf.OptLevel = lto_opt_level(cfg::optimizer_level);
+    conf.CGOptLevel = codegen_opt_level(cfg::optimizer_level);
+    if (!triple.isOSWindows()) conf.RelocModel = llvm::Reloc::PIC_;
+    conf.DisableVerify = !verify_ir();
+
+    auto backend = llvm::lto::createInProcessThinBackend(llvm::heavyweight_hardware_concurrency(jobs));
+    llvm::lto::LTO lto(std::move(conf), backend);
+
+    // inputs refer into their buffers until the link is done
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> buffers;
+    std::set<std::string> defined;
+
+    for (auto& path : bitcode) {
+      auto buffer = llvm::MemoryBuffer::getFile(path);
+      if (!buffer) {
+        std::cerr << "\033[31merror:\033[0m cannot read '" << path << "': " << buffer.getError().message() << "\n";
+        return false;
+      }
+
+      auto input = llvm::lto::InputFile::create((*buffer)->getMemBufferRef());
+      if (!input) return report(input.takeError());
+      buffers.push_back(std::move(*buffer));
+
+      // we are the whole program apart from libc: the first definition
+      // prevails, and only main is referenced from outside the LTO unit
+      std::vector<llvm::lto::SymbolResolution> resolutions;
+      for (auto& sym : (*input)->symbols()) {
+        llvm::lto::SymbolResolution res;
+        if (!sym.isUndefined()) res.Prevailing = defined.insert(sym.getName().str()).second;
+        res.VisibleToRegularObj = sym.getName() == "main";
+        resolutions.push_back(res);
+      }
+
+      if (auto err = lto.add(std::move(*input), resolutions)) return report(std::move(err));
+    }
+
+    std::vector<llvm::SmallVector<char, 0>> results(lto.getMaxTasks());
+
+    auto addStream = [&](size_t task, const llvm::Twine&) -> llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> {
+      return std::make_unique<llvm::CachedFileStream>(std::make_unique<llvm::raw_svector_ostream>(results[task]));
+    };
+
+    std::string cacheDir = build.dir + "/cache/thinlto";
+    auto cache = llvm::localCache("ThinLTO", "thinlto", cacheDir,
+      [&](size_t task, const llvm::Twine&, std::unique_ptr<llvm::MemoryBuffer> buffer) {
+        results[task].assign(buffer->getBufferStart(), buffer->getBufferEnd());
+      });
+    if (!cache) return report(cache.takeError());
+
+    if (auto err = lto.run(addStream, *cache)) return report(std::move(err));
+
+    // default policy: drop entries unused for a week, cap at 75% of free space
+    llvm::pruneCache(cacheDir, llvm::CachePruningPolicy());
+
+    objects.clear();
+    for (size_t task = 0; task < results.size(); task++) {
+      if (results[task].empty()) continue;
+
+      std::string output_file = build.dir + "/cache/lto." + std::to_string(task) + ".o";
+      if (!sonic::io::write_file_atomic(output_file, std::string_view(results[task].data(), results[task].size()))) {
+        std::cerr << "\033[31merror:\033[0m could not write '" << output_file << "'\n";
+        return false;
+      }
+      objects.push_back(output_file);
+    }
+
+    return true;
+  }
+
+  // true when `source` defines something `linked` references but lacks
+  static bool defines_needed(llvm::Module& source, llvm::Module& linked) {
+    for (auto& gv : source.global_values()) {
+      if (gv.hasLocalLinkage() || gv.isDeclarationForLinker()) continue;
+      auto existing = linked.getNamedValue(gv.getName());
+      if (existing && existing->isDeclaration()) return true;
+    }
+    return false;
+  }
+
+  bool full_link(const std::vector<std::string>& bitcode, const BuildTarget& build, std::vector<std::string>& objects) {
+    const TargetKey& key = build.key;
+
+    std::string error;
+    if (!BackendSession::get().initializeTarget(llvm::Triple(key.triple), error)) {
+      std::cerr << "\033[31merror:\033[0m " << error << "\n";
+      return false;
+    }
+    llvm::TargetMachine* machine = BackendSession::get().targetMachine(key);
+
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> buffers;
+    for (auto& path : bitcode) {
+      auto buffer = llvm::MemoryBuffer::getFile(path);
+      if (!buffer) {
+        std::cerr << "\033[31merror:\033[0m cannot read '" << path << "': " << buffer.getError().message() << "\n";
+        return false;
+      }
+      buffers.push_back(std::move(*buffer));
+    }
+
+    llvm::LLVMContext context;
+    auto linked = std::make_unique<llvm::Module>("sonic_lto", context);
+    linked->setTargetTriple(llvm::Triple(key.triple));
+    linked->setDataLayout(machine->createDataLayout());
+
+    // main is the only root; its declaration makes the module defining it
+    // the first one pulled in
+    bool found = false;
+    for (auto& buffer : buffers) {
+      auto lazy = llvm::getLazyBitcodeModule(buffer->getMemBufferRef(), context);
+      if (!lazy) return report(lazy.takeError());
+
+      if (auto main = (*lazy)->getFunction("main"); main && !main->isDeclaration()) {
+        linked->getOrInsertFunction("main", main->getFunctionType());
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      std::cerr << "\033[31merror:\033[0m no module defines 'main'\n";
+      return false;
+    }
+
+    // linking only what is needed materializes just the referenced bodies,
+    // which may reference modules already visited; repeat until no module
+    // has anything left to contribute
+    llvm::Linker linker(*linked);
+    for (bool changed = true; changed; ) {
+      changed = false;
+      for (auto& buffer : buffers) {
+        auto lazy = llvm::getLazyBitcodeModule(buffer->getMemBufferRef(), context);
+        if (!lazy) return report(lazy.takeError());
+        if (!defines_needed(**lazy, *linked)) continue;
+
+        if (linker.linkInModule(std::move(*lazy), llvm::Linker::LinkOnlyNeeded)) {
+          std::cerr << "\033[31merror:\033[0m failed to link '" << buffer->getBufferIdentifier().str() << "'\n";
+          return false;
+        }
+        changed = true;
+      }
+    }
+
+    llvm::internalizeModule(*linked, [](const llvm::GlobalValue& gv) { return gv.getName() == "main"; });
+
+    Optimizer optimizer(context, machine, cfg::optimizer_level);
+    if (!optimizer.runOnLinkedModule(*linked)) return false;
+
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream dest(buffer);
+    llvm::legacy::PassManager pm;
+    if (machine->addPassesToEmitFile(pm, dest, nullptr, llvm::CodeGenFileType::ObjectFile, !verify_ir())) {
+      std::cerr << "\033[31merror:\033[0m target machine cannot emit object files\n";
+      return false;
+    }
+    pm.run(*linked);
+
+    std::string output_file = build.dir + "/cache/lto.full.o";
+    if (!sonic::io::write_file_atomic(output_file, std::string_view(buffer.data(), buffer.size()))) {
+      std::cerr << "\033[31merror:\033[0m could not write '" << output_file << "'\n";
+      return false;
+    }
+
+    objects = {output_file};
+    return true;
+  }
+};
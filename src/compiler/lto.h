@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "backend_session.h"
+
+namespace sonic::backend {
+  // thin link over the summary bitcode written by codegen: imports hot
+  // callees across modules, then optimizes and compiles every module on
+  // its own thread. Backend results are cached in <dir>/cache/thinlto, so
+  // a rebuild only redoes modules whose imports or contents changed.
+  // Writes one object per module and returns their paths in `objects`.
+  bool thin_link(const std::vector<std::string>& bitcode, const BuildTarget& build, unsigned jobs, std::vector<std::string>& objects);
+
+  // full link: modules are loaded lazily and only the definitions reachable
+  // from main are materialized and linked, so memory grows with the code
+  // the program uses rather than with every imported library module. The
+  // linked module is internalized, optimized as a whole and compiled to a
+  // single object, returned in `objects`.
+  bool full_link(const std::vector<std::string>& bitcode, const BuildTarget& build, std::vector<std::string>& objects);
+};
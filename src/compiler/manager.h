@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ast.h"
+#include <memory>
 #include <vector>
 
 using namespace sonic::frontend;
@@ -10,3 +11,12 @@ inline std::vector<ast::Program*> astListManager;
 inline void insert_ast(ast::Program* ast) {
   astListManager.push_back(ast);
 }
+
+// imported modules; symbols point into their ASTs and codegen runs after
+// the whole analysis, so they are kept until the build ends
+inline std::vector<std::unique_ptr<ast::Program>> moduleListManager;
+
+inline ast::Program* keep_module(std::unique_ptr<ast::Program> module) {
+  moduleListManager.push_back(std::move(module));
+  return moduleListManager.back().get();
+}
@@ -0,0 +1,105 @@
+#include "multiversion.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalIFunc.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/TargetParser/Triple.h>
+#include <llvm/TargetParser/X86TargetParser.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+
+namespace sonic::backend {
+  // most capable first, the order the resolver tries them in
+  static const char* const x86_levels[] = {"x86-64-v4", "x86-64-v3", "x86-64-v2"};
+
+  // __builtin_cpu_supports(level): the feature words filled in by
+  // __cpu_indicator_init, in the layout libgcc and compiler-rt share
+  static llvm::Value* cpu_supports(llvm::IRBuilder<>& builder, llvm::Module& module, llvm::StringRef level) {
+    std::array<uint32_t, 4> mask = llvm::X86::getCpuSupportsMask({level});
+
+    llvm::Type* i32 = builder.getInt32Ty();
+    auto modelTy = llvm::StructType::get(i32, i32, i32, llvm::ArrayType::get(i32, 1));
+    auto features2Ty = llvm::ArrayType::get(i32, 3);
+    llvm::Constant* model = module.getOrInsertGlobal("__cpu_model", modelTy);
+    llvm::Constant* features2 = module.getOrInsertGlobal("__cpu_features2", features2Ty);
+
+    llvm::Value* supported = nullptr;
+    for (unsigned word = 0; word < mask.size(); word++) {
+      if (!mask[word]) continue;
+
+      // word 0 is __cpu_model.__cpu_features[0], the rest __cpu_features2
+      llvm::Value* ptr = word == 0
+        ? builder.CreateInBoundsGEP(modelTy, model, {builder.getInt32(0), builder.getInt32(3), builder.getInt32(0)})
+        : builder.CreateConstInBoundsGEP2_32(features2Ty, features2, 0, word - 1);
+
+      llvm::Value* bits = builder.CreateAnd(builder.CreateLoad(i32, ptr), mask[word]);
+      llvm::Value* all = builder.CreateICmpEQ(bits, builder.getInt32(mask[word]));
+      supported = supported ? builder.CreateAnd(supported, all) : all;
+    }
+    return supported ? supported : builder.getTrue();
+  }
+
+  bool emit_multiversion(llvm::Module& module, llvm::Function* fn, const std::vector<std::string>& levels, std::string& error) {
+    const llvm::Triple& triple = module.getTargetTriple();
+    if (!triple.isX86() || !triple.isOSBinFormatELF()) {
+      error = "multiversioning needs an x86 ELF target, not '" + triple.str() + "'";
+      return false;
+    }
+
+    for (auto& level : levels) {
+      if (std::find(std::begin(x86_levels), std::end(x86_levels), level) == std::end(x86_levels)) {
+        error = "unknown ISA level '" + level + "', expected x86-64-v2, x86-64-v3 or x86-64-v4";
+        return false;
+      }
+    }
+
+    std::string name = fn->getName().str();
+    llvm::GlobalValue::LinkageTypes linkage = fn->getLinkage();
+    llvm::LLVMContext& context = module.getContext();
+
+    // each clone is compiled for its level alone; an explicit empty feature
+    // list keeps the module's --cpu/--features from leaking into it
+    std::vector<std::pair<const char*, llvm::Function*>> versions;
+    for (const char* level : x86_levels) {
+      if (!levels.empty() && std::find(levels.begin(), levels.end(), level) == levels.end()) continue;
+
+      llvm::ValueToValueMapTy vmap;
+      llvm::Function* clone = llvm::CloneFunction(fn, vmap);
+      clone->setName(name + "." + level);
+      clone->setLinkage(llvm::GlobalValue::InternalLinkage);
+      clone->addFnAttr("target-cpu", level);
+      clone->addFnAttr("target-features", "");
+      versions.emplace_back(level, clone);
+    }
+
+    fn->setName(name + ".default");
+    fn->setLinkage(llvm::GlobalValue::InternalLinkage);
+
+    auto ptrTy = llvm::PointerType::getUnqual(context);
+    llvm::Function* resolver = llvm::Function::Create(
+      llvm::FunctionType::get(ptrTy, false), llvm::GlobalValue::InternalLinkage, name + ".resolver", module);
+    llvm::GlobalIFunc* ifunc = llvm::GlobalIFunc::create(fn->getFunctionType(), 0, linkage, name, resolver, &module);
+
+    // callers (and recursive calls in the clones) dispatch through the ifunc
+    fn->replaceAllUsesWith(ifunc);
+
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", resolver));
+    builder.CreateCall(module.getOrInsertFunction("__cpu_indicator_init", llvm::FunctionType::get(builder.getVoidTy(), false)));
+
+    for (auto& [level, clone] : versions) {
+      auto use = llvm::BasicBlock::Create(context, level, resolver);
+      auto next = llvm::BasicBlock::Create(context, "", resolver);
+      builder.CreateCondBr(cpu_supports(builder, module, level), use, next);
+
+      llvm::IRBuilder<>(use).CreateRet(clone);
+      builder.SetInsertPoint(next);
+    }
+    builder.CreateRet(fn);
+
+    return true;
+  }
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+
+namespace sonic::backend {
+  // `@multiversion(levels...)`: clones `fn` once per x86-64 ISA level
+  // (x86-64-v2 / v3 / v4, all three when `levels` is empty) and turns its
+  // symbol into an ifunc whose resolver picks the best clone the running
+  // CPU supports, falling back to the original body. Needs an x86 ELF
+  // target; on failure `fn` is left untouched and `error` says why.
+  bool emit_multiversion(llvm::Module& module, llvm::Function* fn, const std::vector<std::string>& levels, std::string& error);
+};
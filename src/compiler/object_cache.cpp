@@ -0,0 +1,130 @@
+#include "object_cache.h"
+#include "ast_io.h"
+#include "profile.h"
+#include "../core/io.h"
+
+#include <cstdint>
+#include <cstring>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/BLAKE3.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace sonic::backend {
+  // entry layout: u32 count, then (u64 size, bytes) per object, little endian
+  static void put(std::string& out, uint64_t v, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) out.push_back(static_cast<char>(v >> (i * 8)));
+  }
+
+  static bool get(const std::string& in, size_t& pos, uint64_t& v, size_t bytes) {
+    if (in.size() - pos < bytes) return false;
+    v = 0;
+    for (size_t i = 0; i < bytes; i++) v |= uint64_t(static_cast<uint8_t>(in[pos + i])) << (i * 8);
+    pos += bytes;
+    return true;
+  }
+
+  ObjectStore::ObjectStore(const std::string& dir, const TargetKey& target, uint64_t limit)
+  : store_(dir, limit) {
+    target_ = target.triple + "\n" + target.cpu + "\n" + target.features + "\n"
+      + pipeline_fingerprint() + "\n" LLVM_VERSION_STRING;
+    store_.trim();
+  }
+
+  std::string ObjectStore::keyFor(const llvm::Module& module) const {
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    llvm::WriteBitcodeToFile(module, os);
+
+    llvm::BLAKE3 hasher;
+    hasher.update(target_);
+    hasher.update(llvm::StringRef(bitcode.data(), bitcode.size()));
+    return llvm::toHex(hasher.final(), true);
+  }
+
+  std::string ObjectStore::keyForSource(const ast::Program& program, const std::string& interface) const {
+    std::string source = sonic::io::read_file(sonic::frontend::ast::io::cachePath(program.name_) + ".ast");
+    if (source.empty()) return "";
+
+    // debug info and the compiler itself change the objects without
+    // changing the AST
+    llvm::BLAKE3 hasher;
+    hasher.update(target_);
+    hasher.update(std::to_string(static_cast<int>(sonic::config::debug_info)) + "\n" + sonic::config::project_root + "\n");
+    hasher.update(sonic::config::APP_VERSION);
+    hasher.update(interface);
+    hasher.update(source);
+    return llvm::toHex(hasher.final(), true);
+  }
+
+  // a type without its source location, which moves with unrelated edits
+  static std::string typeDigest(const ast::Type& type) {
+    std::string digest = "(" + std::to_string(static_cast<int>(type.kind_)) + " " + std::to_string(static_cast<int>(type.literal_))
+      + " " + type.name_ + " " + std::to_string(type.nullable_) + std::to_string(type.restrict_);
+    if (type.nested_) digest += " " + typeDigest(*type.nested_);
+    for (auto& generic : type.generics_) digest += " " + typeDigest(*generic);
+    return digest + ")";
+  }
+
+  static void hashDeclarations(Symbol* scope, llvm::BLAKE3& hasher) {
+    for (Symbol* sym : scope->children_) {
+      std::string entry = std::to_string(static_cast<int>(sym->kind_)) + " " + sym->name_ + " " + sym->mangle_;
+      switch (sym->kind_) {
+        case SymbolKind::NAMESPACE:
+          hasher.update(entry + "{\n");
+          hashDeclarations(sym, hasher);
+          hasher.update("}\n");
+          continue;
+        case SymbolKind::ALIAS:
+          if (sym->ref_) entry += " -> " + sym->ref_->mangle_;
+          break;
+        case SymbolKind::FUNCTION:
+        case SymbolKind::VARIABLE:
+          entry += " " + std::to_string(sym->public_) + std::to_string(sym->extern_) + std::to_string(sym->async_)
+            + std::to_string(sym->decl_) + std::to_string(sym->variadic_) + std::to_string(static_cast<int>(sym->mutability_));
+          if (sym->type_) entry += " " + typeDigest(*sym->type_);
+          for (auto param : sym->params_) entry += " " + typeDigest(*param);
+          break;
+        default:
+          break;
+      }
+      hasher.update(entry + "\n");
+    }
+  }
+
+  std::string ObjectStore::interfaceOf(Symbol* root) {
+    llvm::BLAKE3 hasher;
+    if (root) hashDeclarations(root, hasher);
+    return llvm::toHex(hasher.final(), true);
+  }
+
+  bool ObjectStore::load(const std::string& key, std::vector<std::string>& objects) {
+    std::string entry;
+    if (!store_.load(key, entry)) return false;
+
+    size_t pos = 0;
+    uint64_t count = 0;
+    if (!get(entry, pos, count, 4) || count == 0) return false;
+
+    objects.clear();
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t size = 0;
+      if (!get(entry, pos, size, 8) || entry.size() - pos < size) return false;
+      objects.emplace_back(entry, pos, size);
+      pos += size;
+    }
+    return pos == entry.size();
+  }
+
+  bool ObjectStore::store(const std::string& key, const std::vector<std::string_view>& objects) {
+    std::string entry;
+    put(entry, objects.size(), 4);
+    for (auto& object : objects) {
+      put(entry, object.size(), 8);
+      entry.append(object.data(), object.size());
+    }
+    return store_.store(key, entry);
+  }
+};
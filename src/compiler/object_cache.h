@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <llvm/IR/Module.h>
+
+#include "ast.h"
+#include "backend_session.h"
+#include "symbol.h"
+#include "../core/config.h"
+#include "../core/content_store.h"
+
+using namespace sonic::frontend;
+
+namespace sonic::backend {
+  // objects of compiled modules, kept in build/cache/objects/. The key is
+  // taken from the IR before optimization, so a hit skips both the
+  // optimizer and the backend. An entry holds every object the module was
+  // compiled to (one per partition with -j).
+  class ObjectStore {
+    public:
+    ObjectStore(const std::string& dir, const TargetKey& target, uint64_t limit);
+
+    std::string keyFor(const llvm::Module& module) const;
+    // key known before lowering: the module's cached .ast and the project
+    // interface (see interfaceOf); empty when the .ast cannot be read
+    std::string keyForSource(const ast::Program& program, const std::string& interface) const;
+    // digest of every declaration a module can reference: functions and
+    // globals of all namespaces, without function bodies, so editing a
+    // body keeps the other modules' source keys
+    static std::string interfaceOf(Symbol* root);
+
+    bool contains(const std::string& key) const { return store_.contains(key); }
+
+    // false on a miss or a malformed entry
+    bool load(const std::string& key, std::vector<std::string>& objects);
+    bool store(const std::string& key, const std::vector<std::string_view>& objects);
+
+    size_t hits() const { return store_.hits(); }
+    size_t misses() const { return store_.misses(); }
+
+    private:
+    sonic::io::ContentStore store_;
+    std::string target_;
+  };
+
+  // only plain object builds are cached, the other outputs need the module
+  inline bool objects_cacheable() {
+    return sonic::config::object_cache && sonic::config::emit_kinds == sonic::config::EMIT_OBJ && sonic::config::lto_mode == sonic::config::LTO_NONE;
+  }
+};
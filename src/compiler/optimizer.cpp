@@ -0,0 +1,144 @@
+#include "optimizer.h"
+
+#include <iostream>
+#include <optional>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar/EarlyCSE.h>
+#include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
+
+namespace cfg = sonic::config;
+
+namespace sonic::backend {
+  llvm::OptimizationLevel optimization_level(cfg::OptLevel level) {
+    switch (level) {
+      case cfg::OptLevel::NO: return llvm::OptimizationLevel::O0;
+      case cfg::OptLevel::O2: return llvm::OptimizationLevel::O2;
+      case cfg::OptLevel::O3:
+      case cfg::OptLevel::OFAST: return llvm::OptimizationLevel::O3;
+    }
+    return llvm::OptimizationLevel::O2;
+  }
+
+  llvm::CodeGenOptLevel codegen_opt_level(cfg::OptLevel level) {
+    switch (level) {
+      case cfg::OptLevel::NO: return llvm::CodeGenOptLevel::None;
+      case cfg::OptLevel::O2: return llvm::CodeGenOptLevel::Default;
+      case cfg::OptLevel::O3:
+      case cfg::OptLevel::OFAST: return llvm::CodeGenOptLevel::Aggressive;
+    }
+    return llvm::CodeGenOptLevel::Default;
+  }
+
+  // the dev profile trusts codegen in release builds of the compiler,
+  // debug builds keep checking every module
+  bool verify_ir() {
+#ifdef NDEBUG
+    return cfg::build_profile != cfg::PROFILE_DEV;
+#else
+    return true;
+#endif
+  }
+
+  // IR instrumentation and its use; the default pipelines place the
+  // instrumentation, profile annotation and the runtime hooks themselves
+  static std::optional<llvm::PGOOptions> pgo_options() {
+    if (cfg::profile_generate) {
+      return llvm::PGOOptions(cfg::profile_dir + "/default_%m.profraw", "", "", "",
+        llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRInstr);
+    }
+    if (!cfg::profile_use.empty()) {
+      return llvm::PGOOptions(cfg::profile_use, "", "", "",
+        llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRUse);
+    }
+    return std::nullopt;
+  }
+
+  Optimizer::Optimizer(llvm::LLVMContext& context, llvm::TargetMachine* targetMachine, cfg::OptLevel level)
+  : level_(level)
+  {
+    SI = std::make_unique<llvm::StandardInstrumentations>(context, false);
+    SI->registerCallbacks(PIC, &MAM);
+
+    PB = std::make_unique<llvm::PassBuilder>(targetMachine, llvm::PipelineTuningOptions(), pgo_options(), &PIC);
+    PB->registerModuleAnalyses(MAM);
+    PB->registerCGSCCAnalyses(CGAM);
+    PB->registerFunctionAnalyses(FAM);
+    PB->registerLoopAnalyses(LAM);
+    PB->crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    if (level_ != cfg::OptLevel::NO) {
+      // promote the allocas codegen emits for every local before anything
+      // else sees the function
+      FPM.addPass(llvm::PromotePass());
+      FPM.addPass(llvm::EarlyCSEPass());
+      FPM.addPass(llvm::InstCombinePass());
+      FPM.addPass(llvm::SimplifyCFGPass());
+    }
+  }
+
+  void Optimizer::runOnFunction(llvm::Function& function) {
+    if (level_ == cfg::OptLevel::NO || function.isDeclaration()) return;
+
+    // never hand broken IR to the pipeline
+    if (verify_ir() && llvm::verifyFunction(function, &llvm::errs())) {
+      llvm::errs() << "warning: skipping optimization of invalid function '" << function.getName() << "'\n";
+      return;
+    }
+
+    FPM.run(function, FAM);
+  }
+
+  bool Optimizer::runOnModule(llvm::Module& module) {
+    if (verify_ir() && llvm::verifyModule(module, &llvm::errs())) {
+      std::cerr << "\033[31merror:\033[0m invalid IR in module '" << module.getModuleIdentifier() << "'\n";
+      return false;
+    }
+
+    // function analyses cached while generating are stale by now
+    FAM.clear();
+    MAM.clear();
+
+    // with LTO the module is only pre-optimized; inlining across modules
+    // and the rest of the pipeline run after the link
+    auto phase = llvm::ThinOrFullLTOPhase::None;
+    if (cfg::lto_mode == cfg::LTO_THIN) phase = llvm::ThinOrFullLTOPhase::ThinLTOPreLink;
+    else if (cfg::lto_mode == cfg::LTO_FULL) phase = llvm::ThinOrFullLTOPhase::FullLTOPreLink;
+
+    llvm::ModulePassManager MPM;
+    if (level_ == cfg::OptLevel::NO)
+      MPM = PB->buildO0DefaultPipeline(llvm::OptimizationLevel::O0, phase);
+    else if (phase == llvm::ThinOrFullLTOPhase::ThinLTOPreLink)
+      MPM = PB->buildThinLTOPreLinkDefaultPipeline(optimization_level(level_));
+    else if (phase == llvm::ThinOrFullLTOPhase::FullLTOPreLink)
+      MPM = PB->buildLTOPreLinkDefaultPipeline(optimization_level(level_));
+    else
+      MPM = PB->buildPerModuleDefaultPipeline(optimization_level(level_));
+
+    MPM.run(module, MAM);
+    return true;
+  }
+
+  bool Optimizer::runOnLinkedModule(llvm::Module& module) {
+    if (verify_ir() && llvm::verifyModule(module, &llvm::errs())) {
+      std::cerr << "\033[31merror:\033[0m invalid IR in module '" << module.getModuleIdentifier() << "'\n";
+      return false;
+    }
+
+    FAM.clear();
+    MAM.clear();
+
+    llvm::ModulePassManager MPM;
+    if (level_ == cfg::OptLevel::NO)
+      MPM = PB->buildO0DefaultPipeline(llvm::OptimizationLevel::O0, llvm::ThinOrFullLTOPhase::FullLTOPostLink);
+    else
+      MPM = PB->buildLTODefaultPipeline(optimization_level(level_), nullptr);
+
+    MPM.run(module, MAM);
+    return true;
+  }
+};
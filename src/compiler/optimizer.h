@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "../core/config.h"
+
+namespace sonic::backend {
+  llvm::OptimizationLevel optimization_level(sonic::config::OptLevel level);
+  llvm::CodeGenOptLevel codegen_opt_level(sonic::config::OptLevel level);
+
+  // whether generated IR is verified before it is optimized or emitted
+  bool verify_ir();
+
+  // new pass manager pipeline for one llvm::Module: a light function
+  // simplification pipeline run while IR is generated, and the PassBuilder
+  // default module pipeline run once before emission
+  class Optimizer {
+    public:
+    Optimizer(llvm::LLVMContext& context, llvm::TargetMachine* targetMachine, sonic::config::OptLevel level);
+
+    void runOnFunction(llvm::Function& function);
+    // false, with nothing run, if the module fails verification
+    bool runOnModule(llvm::Module& module);
+    // whole program pipeline after --lto=full linked every module into one
+    bool runOnLinkedModule(llvm::Module& module);
+
+    private:
+    sonic::config::OptLevel level_;
+
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    llvm::PassInstrumentationCallbacks PIC;
+    std::unique_ptr<llvm::StandardInstrumentations> SI;
+    std::unique_ptr<llvm::PassBuilder> PB;
+
+    llvm::FunctionPassManager FPM;
+  };
+};
@@ -30,6 +30,23 @@ namespace sonic::frontend {
     auto stmt = std::make_unique<Statement>();
     stmt->loc_ = current_token->location;
 
+    if (match(TokenType::AT)) {
+      std::vector<std::unique_ptr<Statement>> attributes;
+      while (match(TokenType::AT)) attributes.push_back(parse_attribute());
+
+      auto decl = parse_stmt();
+      if (decl->kind_ != StmtKind::FUNCTION) {
+        diag->report({
+          ErrorType::SYNTAX,
+          Severity::ERROR,
+          attributes.front()->loc_,
+          "attributes are only allowed on functions"
+        });
+      }
+      decl->attributes_ = std::move(attributes);
+      return decl;
+    }
+
     if (match(TokenType::IDENT)) {
       return parse_assignment();
     }
@@ -322,6 +339,32 @@ namespace sonic::frontend {
     return stmt;
   }
 
+  std::unique_ptr<Statement> Parser::parse_attribute() {
+    auto attr = std::make_unique<Statement>();
+    attr->kind_ = StmtKind::MACRO_ATTR;
+    attr->loc_ = current_token->location;
+    expect(TokenType::AT);
+
+    attr->name_ = expect(TokenType::IDENT)->value;
+
+    if (match(TokenType::LEFTPAREN)) {
+      next();
+      while (!match(TokenType::RIGHTPAREN) && !match(TokenType::ENDOFFILE)) {
+        auto arg = std::make_unique<Statement>();
+        arg->kind_ = StmtKind::PARAMETER;
+        arg->loc_ = current_token->location;
+        arg->name_ = expect(match(TokenType::STRLIT) ? TokenType::STRLIT : TokenType::IDENT)->value;
+        attr->params_.push_back(std::move(arg));
+
+        if (!match(TokenType::COMMA)) break;
+        next();
+      }
+      expect(TokenType::RIGHTPAREN);
+    }
+
+    return attr;
+  }
+
   int Parser::parse_precedence(TokenType t) {
     switch (t) {
       // paling tinggi
@@ -400,17 +443,18 @@ namespace sonic::frontend {
         stmt->loc_ = previous_token->location;
         skip_semicolon();
         return stmt;
-      } else if (match(TokenType::IS_EQUAL) || match(TokenType::NOT_EQUAL) ||
-                 match(TokenType::PLUS_EQUAL) || match(TokenType::MINUS_EQUAL) ||
+      } else if (match(TokenType::PLUS_EQUAL) || match(TokenType::MINUS_EQUAL) ||
                  match(TokenType::STAR_EQUAL) || match(TokenType::DIV_EQUAL) ||
                  match(TokenType::PERCENT_EQUAL) || match(TokenType::POWER_EQUAL)) {
         std::string op = current_token->value;
         next();
         stmt->kind_ = StmtKind::ASSIGNMENT;
         stmt->assign_ = expr->clone();
+        stmt->loc_ = previous_token->location;
         stmt->value_ = std::make_unique<Expression>();
         stmt->value_->kind_ = ExprKind::BINARY;
         stmt->value_->value_ = op;
+        stmt->value_->loc_ = previous_token->location;
         stmt->value_->lhs_ = std::move(expr);
         stmt->value_->rhs_ = parse_expr();
         if (!stmt->value_->rhs_) {
@@ -517,11 +561,13 @@ namespace sonic::frontend {
 
       next();
 
-      auto bin = std::unique_ptr<Expression>();
+      auto bin = std::make_unique<Expression>();
       bin->kind_ = ExprKind::BINARY;
       bin->value_ = op->value;
-      bin->lhs_ = left->clone();
-      bin->rhs_ = parse_binop(precedence + 1);
+      bin->loc_ = op->location;
+      bin->lhs_ = std::move(left);
+      // ** groups to the right: 2 ** 3 ** 2 is 2 ** 9
+      bin->rhs_ = parse_binop(op->type == TokenType::POWER ? precedence : precedence + 1);
       left = std::move(bin);
     }
 
@@ -531,11 +577,13 @@ namespace sonic::frontend {
   std::unique_ptr<Expression> Parser::parse_value() {
     auto expr = std::make_unique<Expression>();
 
-    if (match(TokenType::MINUS)) {
+    // unary operators bind tighter than any binary one: -a + b is (-a) + b
+    if (match(TokenType::MINUS) || match(TokenType::EXCLAMATION)) {
       next();
       expr->kind_ = ExprKind::UNARY;
       expr->value_ = previous_token->value;
-      expr->nested_ = parse_expr();
+      expr->loc_ = previous_token->location;
+      expr->nested_ = parse_value();
       return expr;
     }
 
@@ -591,19 +639,34 @@ namespace sonic::frontend {
       return expr;
     }
 
-    if (match(TokenType::STAR)) {
+    // like the unary operators above: *a + *b is (*a) + (*b)
+    if (match(TokenType::POWER) && current_token->value == "**") {
+      // **pp lexes as the power operator, it is two dereferences
+      next();
+      auto inner = std::make_unique<Expression>();
+      inner->kind_ = ExprKind::DEREF;
+      inner->value_ = "*";
+      inner->loc_ = previous_token->location;
+      inner->nested_ = parse_value();
+
+      expr->kind_ = ExprKind::DEREF;
+      expr->value_ = "*";
+      expr->loc_ = inner->loc_;
+      expr->nested_ = std::move(inner);
+      return expr;
+    } else if (match(TokenType::STAR)) {
       next();
       expr->kind_ = ExprKind::DEREF;
       expr->value_ = previous_token->value;
       expr->loc_ = previous_token->location;
-      expr->nested_ = parse_expr();
+      expr->nested_ = parse_value();
       return expr;
     } else if (match(TokenType::AMPERSAND)) {
       next();
       expr->kind_ = ExprKind::REF;
       expr->value_ = previous_token->value;
       expr->loc_ = previous_token->location;
-      expr->nested_ = parse_expr();
+      expr->nested_ = parse_value();
       return expr;
     }
 
@@ -771,22 +834,33 @@ namespace sonic::frontend {
       }
     }
 
+    auto wrap = [&](TypeKind kind) {
+      auto outer = std::make_unique<Type>();
+      outer->kind_ = kind;
+      outer->nested_ = std::move(type);
+      outer->loc_ = current_token->location;
+      type = std::move(outer);
+    };
+
     if (match(TokenType::QUESTION)) {
       type->nullable_ = true;
       next();
-    } else if (match(TokenType::STAR)) {
-      auto ptrType = std::make_unique<Type>();
-      ptrType->kind_ = TypeKind::PTR;
-      ptrType->nested_ = std::move(type);
-      ptrType->loc_ = current_token->location;
-      type = std::move(ptrType);
-      next();
-    } else if (match(TokenType::AMPERSAND)) {
-      auto refType = std::make_unique<Type>();
-      refType->kind_ = TypeKind::REF;
-      refType->nested_ = std::move(type);
-      refType->loc_ = current_token->location;
-      type = std::move(refType);
+    } else {
+      // i32** lexes as i32 followed by the power operator
+      for (;;) {
+        if (match(TokenType::STAR)) wrap(TypeKind::PTR);
+        else if (match(TokenType::POWER) && current_token->value == "**") {
+          wrap(TypeKind::PTR);
+          wrap(TypeKind::PTR);
+        }
+        else if (match(TokenType::AMPERSAND)) wrap(TypeKind::REF);
+        else break;
+        next();
+      }
+    }
+
+    if ((type->kind_ == TypeKind::PTR || type->kind_ == TypeKind::REF) && match(TokenType::RESTRICT)) {
+      type->restrict_ = true;
       next();
     }
 
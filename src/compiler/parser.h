@@ -35,6 +35,7 @@ namespace sonic::frontend {
   private:
     std::unique_ptr<Statement> parse_stmt();
     std::unique_ptr<Statement> parse_assignment();
+    std::unique_ptr<Statement> parse_attribute();
 
     std::unique_ptr<Expression> parse_expr();
     std::unique_ptr<Expression> parse_binop(int prec);
@@ -0,0 +1,110 @@
+#include "profile.h"
+#include "../core/config.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ProfileData/InstrProfReader.h>
+#include <llvm/ProfileData/InstrProfWriter.h>
+#include <llvm/Support/BLAKE3.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace cfg = sonic::config;
+namespace fs = std::filesystem;
+
+namespace sonic::backend {
+  static bool report(const std::string& path, llvm::Error error) {
+    std::cerr << "\033[31merror:\033[0m " << path << ": " << llvm::toString(std::move(error)) << "\n";
+    return false;
+  }
+
+  static bool is_profile(const fs::path& path) {
+    return path.extension() == ".profraw" || path.extension() == ".profdata";
+  }
+
+  bool merge_profiles(const std::vector<std::string>& inputs, const std::string& output) {
+    std::vector<std::string> files;
+    for (auto& input : inputs) {
+      std::error_code ec;
+      if (!fs::is_directory(input, ec)) {
+        files.push_back(input);
+        continue;
+      }
+
+      for (auto& entry : fs::directory_iterator(input, ec)) {
+        if (entry.is_regular_file(ec) && is_profile(entry.path())) files.push_back(entry.path().string());
+      }
+    }
+    // the merged counts do not depend on the order, the output layout does
+    std::sort(files.begin(), files.end());
+
+    if (files.empty()) {
+      std::cerr << "\033[31merror:\033[0m no profiles to merge\n";
+      return false;
+    }
+
+    auto vfs = llvm::vfs::getRealFileSystem();
+    llvm::InstrProfWriter writer;
+
+    for (auto& file : files) {
+      auto reader = llvm::InstrProfReader::create(file, *vfs);
+      if (!reader) return report(file, reader.takeError());
+
+      // raw profiles of IR instrumentation must stay marked as such, or
+      // --profile-use rejects the merged file
+      if (auto err = writer.mergeProfileKind((*reader)->getProfileKind())) return report(file, std::move(err));
+
+      bool failed = false;
+      for (auto& record : **reader) {
+        writer.addRecord(std::move(record), 1, [&](llvm::Error err) {
+          report(file, std::move(err));
+          failed = true;
+        });
+      }
+      if ((*reader)->hasError()) return report(file, (*reader)->getError());
+      if (failed) return false;
+    }
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(output, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+      std::cerr << "\033[31merror:\033[0m cannot write '" << output << "': " << ec.message() << "\n";
+      return false;
+    }
+    if (auto err = writer.write(os)) return report(output, std::move(err));
+
+    return true;
+  }
+
+  std::string resolve_profile(const std::string& path) {
+    if (fs::path(path).extension() == ".profdata") return path;
+
+    std::string merged = cfg::project_build + "/cache/merged.profdata";
+    std::error_code ec;
+    fs::create_directories(fs::path(merged).parent_path(), ec);
+
+    if (!merge_profiles({path}, merged)) return "";
+    return merged;
+  }
+
+  std::string pipeline_fingerprint() {
+    std::string fingerprint = std::to_string(static_cast<int>(cfg::optimizer_level));
+
+    if (cfg::profile_generate) fingerprint += "\ngenerate:" + cfg::profile_dir;
+
+    if (!cfg::profile_use.empty()) {
+      llvm::BLAKE3 hasher;
+      if (auto buffer = llvm::MemoryBuffer::getFile(cfg::profile_use)) {
+        hasher.update((*buffer)->getBuffer());
+      }
+      fingerprint += "\nuse:" + llvm::toHex(hasher.final(), true);
+    }
+
+    return fingerprint;
+  }
+};
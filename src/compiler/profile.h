@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sonic::backend {
+  // merges raw (.profraw) and indexed (.profdata) instrumentation profiles
+  // into one indexed profile, as `llvm-profdata merge` does. Directories
+  // are searched (not recursively) for such files.
+  bool merge_profiles(const std::vector<std::string>& inputs, const std::string& output);
+
+  // the indexed profile to optimize with for --profile-use=<path>: a
+  // .profdata file as is, anything else merged into build/cache first.
+  // Empty on failure.
+  std::string resolve_profile(const std::string& path);
+
+  // pipeline settings that change generated code besides the IR and the
+  // target (opt level, PGO mode and profile contents), for cache keys
+  std::string pipeline_fingerprint();
+};
@@ -17,10 +17,8 @@
 #include "ast_io.h"
 #include "symbol.h"
 #include "../core/config.h"
-#include "codegen.h"
 
 using namespace sonic::debug;
-using namespace sonic::backend;
 
 namespace sonic::frontend {
   using namespace ast;
@@ -48,13 +46,18 @@ namespace sonic::frontend {
     for (auto& st : pg->statements_) analyze_statement(st.get());
     symbols = groups;
 
-    // save AST and Symbol info to cache
-    sonic::io::create_folder(sonic::io::getFullPath(config::project_build + "/"));
-    sonic::io::create_folder(sonic::io::getFullPath(config::project_build + "/cache/"));
-    sonic::frontend::ast::io::saveProgramToFile(*pg, sonic::io::getFullPath(config::project_build + "/cache/" + sonic::io::getFileNameWithoutExt(filepath + "/" + program->name_) + ".ast.json"));
+    // save AST and Symbol info to cache (a cached program is already there)
+    if (!pg->cached_) {
+      sonic::io::create_folder(sonic::io::getFullPath(config::project_build + "/"));
+      sonic::io::create_folder(sonic::io::getFullPath(config::project_build + "/cache/"));
+      std::string cachePath = getCachePath(program->name_);
+      sonic::frontend::ast::io::saveProgramToFile(*pg, cachePath + ".ast");
+      if (config::runtime_debug)
+        sonic::frontend::ast::io::saveProgramToJson(*pg, cachePath + ".ast.json", config::json_compact);
+    }
 
-    sonic::backend::SonicCodegen codegen(symbols);
-    codegen.generate(pg);
+    // IR is generated once the whole project is analyzed (see generate_modules)
+    insert_ast(pg);
   }
 
   void SemanticAnalyzer::eager_analyze(Statement* st) {
@@ -99,6 +102,24 @@ namespace sonic::frontend {
           function->public_ = true;
         }
 
+        for (auto& attr : st->attributes_) {
+          if (attr->name_ != "multiversion") {
+            diag->report({
+              ErrorType::SEMANTIC,
+              Severity::WARNING,
+              attr->loc_,
+              "unknown attribute '" + attr->name_ + "'"
+            });
+          } else if (st->declare_) {
+            diag->report({
+              ErrorType::SEMANTIC,
+              Severity::ERROR,
+              attr->loc_,
+              "'multiversion' needs a function body"
+            });
+          }
+        }
+
         st->symbols_ = function;
         symbols->declare(function);
 
@@ -127,6 +148,16 @@ namespace sonic::frontend {
           analyze_type(arg->type_.get());
           arg->type_->symbols_ = lookup_type(arg->type_.get());
           function->params_.push_back(arg->type_.get());
+
+          auto param = new Symbol();
+          param->kind_ = SymbolKind::VARIABLE;
+          param->scope_ = ScopeLevel::FUNCTION;
+          param->name_ = arg->name_;
+          param->mangle_ = function->mangle_ + "_" + arg->name_;
+          param->type_ = arg->type_.get();
+          param->parent_ = function;
+          arg->symbols_ = param;
+          function->declare(param);
         }
 
         if (st->type_) {
@@ -146,7 +177,7 @@ namespace sonic::frontend {
 
     switch (st->kind_) {
       case StmtKind::IMPORT: {
-        std::unique_ptr<ast::Program> module = nullptr;
+        ast::Program* module = nullptr;
         Symbol* moduleNamespace = nullptr;
 
         // Resolve the module path using flexible search strategy
@@ -271,24 +302,20 @@ namespace sonic::frontend {
         break;
       }
       case StmtKind::FUNCTION: {
-        auto temp = symbols;
-        symbols = (Symbol*)st->symbols_;
-
-        if (st->declare_) {
-          symbols = temp;
-          break;
-        }
-
-        for (auto& ch : st->body_)
-          analyze_statement(ch.get());
-
-        symbols = temp;
+        // bodies of cached modules stay encoded until analyze_bodies()
+        if (st->declare_ || st->lazy_body_) break;
+        analyze_body(st);
         break;
       }
       case StmtKind::RETURN: {
         analyze_expression(st->value_.get());
+
+        // returns inside `if` / `while` bodies belong to the enclosing function
+        Symbol* function = symbols;
+        while (function->kind_ == SymbolKind::BLOCK && function->parent_) function = function->parent_;
+
         if (st->value_) {
-          if (symbols->type_) {
+          if (function->type_) {
             // return with value
             if (st->value_->type_->isIntegerType()) {
               if (st->value_->bitWidth() <= 64 && st->value_ != 0) {
@@ -305,7 +332,7 @@ namespace sonic::frontend {
                 // todo -> error
               }
             }
-            else if (match_type(symbols->type_, st->value_->type_)) {
+            else if (match_type(function->type_, st->value_->type_)) {
               // type match
             } else {
               diag->report({
@@ -325,7 +352,7 @@ namespace sonic::frontend {
             });
           }
         } else {
-          if (symbols->type_) {
+          if (function->type_) {
             diag->report({
               ErrorType::SEMANTIC,
               Severity::ERROR,
@@ -348,6 +375,7 @@ namespace sonic::frontend {
         }
 
         auto variable = new Symbol();
+        variable->kind_ = SymbolKind::VARIABLE;
         variable->name_ = st->name_;
         variable->mangle_ = symbols->mangle_ + "_" + st->name_;
         variable->public_ = st->public_;
@@ -382,20 +410,150 @@ namespace sonic::frontend {
             // todo -> error
           }
         }
+        variable->type_ = st->type_.get();
 
         symbols->declare(variable);
 
         break;
       }
+      case StmtKind::ASSIGNMENT: {
+        analyze_expression(st->assign_.get());
+        analyze_expression(st->value_.get());
+
+        auto target = st->assign_ ? (Symbol*)st->assign_->symbols_ : nullptr;
+        if (target && target->kind_ == SymbolKind::VARIABLE && target->mutability_ == Mutability::CONSTANT) {
+          diag->report({
+            ErrorType::SEMANTIC,
+            Severity::ERROR,
+            st->loc_,
+            "cannot assign to constant '" + target->name_ + "'"
+          });
+        }
+        break;
+      }
       case StmtKind::EXPR: {
         analyze_expression(st->value_.get());
         break;
       }
+      case StmtKind::IF_ELSE: {
+        analyze_expression(st->value_.get());
+        analyze_block(st->then_);
+        analyze_block(st->else_);
+        break;
+      }
+      case StmtKind::WHILE_LOOP: {
+        analyze_expression(st->value_.get());
+        analyze_block(st->body_);
+        break;
+      }
       default:
         return;
     }
   }
 
+  void SemanticAnalyzer::analyze_body(Statement* st) {
+    auto temp = symbols;
+    symbols = (Symbol*)st->symbols_;
+
+    for (auto& ch : st->body_)
+      analyze_statement(ch.get());
+
+    symbols = temp;
+  }
+
+  void SemanticAnalyzer::analyze_bodies(Program* pg) {
+    std::vector<Statement*> damaged;
+    analyze_lazy_bodies(pg->statements_, damaged);
+    if (!damaged.empty()) reparse_bodies(pg, damaged);
+  }
+
+  void SemanticAnalyzer::analyze_lazy_bodies(std::vector<std::unique_ptr<Statement>>& statements, std::vector<Statement*>& damaged) {
+    for (auto& st : statements) {
+      if (st->kind_ == StmtKind::NAMESPACE) {
+        analyze_lazy_bodies(st->body_, damaged);
+        continue;
+      }
+      if (st->kind_ != StmtKind::FUNCTION || !st->lazy_body_ || st->declare_) continue;
+
+      if (st->materialize()) analyze_body(st.get());
+      else damaged.push_back(st.get());
+    }
+  }
+
+  // a cached body that cannot be decoded is taken from the source instead;
+  // the damaged cache entry is dropped, and written again once every body
+  // is recovered
+  void SemanticAnalyzer::reparse_bodies(Program* pg, const std::vector<Statement*>& damaged) {
+    namespace fs = std::filesystem;
+
+    std::string source = fs::path(pg->name_).is_absolute() ? pg->name_ : sonic::config::project_root + "/" + pg->name_;
+    std::string cacheFile = getCachePath(source) + ".ast";
+    std::error_code ec;
+    fs::remove(cacheFile, ec);
+
+    std::string content = sonic::io::read_file(source);
+    sonic::frontend::Lexer lexer(content, sonic::io::getFullPath(source));
+    lexer.diag = diag;
+    sonic::frontend::Parser parser(sonic::io::getFullPath(source), &lexer);
+    parser.diag = diag;
+    auto parsed = parser.parse();
+
+    // functions are matched by name and line, both kept in the cache
+    std::vector<Statement*> functions;
+    std::vector<std::vector<std::unique_ptr<Statement>>*> pending;
+    if (parsed) pending.push_back(&parsed->statements_);
+    while (!pending.empty()) {
+      auto list = pending.back();
+      pending.pop_back();
+      for (auto& st : *list) {
+        if (st->kind_ == StmtKind::FUNCTION) functions.push_back(st.get());
+        else if (st->kind_ == StmtKind::NAMESPACE) pending.push_back(&st->body_);
+      }
+    }
+
+    size_t recovered = 0;
+    for (auto st : damaged) {
+      auto found = std::find_if(functions.begin(), functions.end(), [&](Statement* fn) {
+        return fn->name_ == st->name_ && fn->loc_.line == st->loc_.line;
+      });
+
+      if (found == functions.end()) {
+        diag->report({
+          ErrorType::INTERNAL,
+          Severity::ERROR,
+          st->loc_,
+          "cached body of '" + st->name_ + "' is damaged and the source no longer matches, rebuild the module"
+        });
+        continue;
+      }
+
+      st->body_ = std::move((*found)->body_);
+      analyze_body(st);
+      recovered++;
+    }
+
+    if (recovered == damaged.size()) sonic::frontend::ast::io::saveProgramToFile(*pg, cacheFile);
+  }
+
+  // `if` and `while` bodies are scopes of their own: locals declared in
+  // them may shadow outer names and end with the block
+  void SemanticAnalyzer::analyze_block(std::vector<std::unique_ptr<Statement>>& body) {
+    if (body.empty()) return;
+
+    auto block = new Symbol();
+    block->kind_ = SymbolKind::BLOCK;
+    block->scope_ = ScopeLevel::FUNCTION;
+    block->mangle_ = symbols->mangle_;
+    block->parent_ = symbols;
+    // not declared by name, so lookups from the enclosing scope skip it
+    symbols->children_.push_back(block);
+
+    auto temp = symbols;
+    symbols = block;
+    for (auto& ch : body) analyze_statement(ch.get());
+    symbols = temp;
+  }
+
   void SemanticAnalyzer::analyze_expression(Expression* ex) {
     if (!ex) return;
     ex->type_ = new Type();
@@ -487,10 +645,96 @@ namespace sonic::frontend {
         ex->symbols_ = sym;
         break;
       }
+      case ExprKind::REF: {
+        analyze_expression(ex->nested_.get());
+        if (!ex->nested_ || !ex->nested_->type_) break;
+
+        ex->type_->kind_ = TypeKind::PTR;
+        ex->type_->nested_ = ex->nested_->type_->clone();
+        break;
+      }
+      case ExprKind::DEREF:
+      case ExprKind::INDEX: {
+        analyze_expression(ex->nested_.get());
+        analyze_expression(ex->index_.get());
+        if (!ex->nested_ || !ex->nested_->type_) break;
+
+        // the pointee of `*p` and `p[i]`
+        Type* pointer = ex->nested_->type_;
+        if ((pointer->kind_ == TypeKind::PTR || pointer->kind_ == TypeKind::REF) && pointer->nested_) {
+          ex->type_ = pointer->nested_.get();
+        }
+        break;
+      }
+      case ExprKind::BINARY: {
+        analyze_expression(ex->lhs_.get());
+        analyze_expression(ex->rhs_.get());
+        if (!ex->lhs_ || !ex->rhs_) break;
+
+        // an untyped number takes the type of the other operand
+        adopt_literal_type(ex->lhs_.get(), ex->rhs_->type_);
+        adopt_literal_type(ex->rhs_.get(), ex->lhs_->type_);
+
+        const std::string& op = ex->value_;
+        if (op == "<" || op == "<=" || op == ">" || op == ">=" || op == "==" || op == "!=" || op == "&&" || op == "||") {
+          ex->type_->kind_ = TypeKind::LITERAL;
+          ex->type_->literal_ = LiteralKind::BOOL;
+        } else if (ex->lhs_->type_) {
+          ex->type_ = ex->lhs_->type_;
+        }
+        break;
+      }
+      case ExprKind::UNARY: {
+        analyze_expression(ex->nested_.get());
+        if (!ex->nested_) break;
+
+        if (ex->value_ == "!") {
+          ex->type_->kind_ = TypeKind::LITERAL;
+          ex->type_->literal_ = LiteralKind::BOOL;
+        } else if (ex->nested_->type_) {
+          ex->type_ = ex->nested_->type_;
+        }
+        break;
+      }
       default: return;
     }
   }
 
+  void SemanticAnalyzer::adopt_literal_type(Expression* literal, Type* type) {
+    if (!type || type->kind_ != TypeKind::LITERAL) return;
+
+    // a subexpression of literals only, such as 2 ** 3, is retyped as a whole
+    bool arithmetic = literal->kind_ == ExprKind::BINARY || (literal->kind_ == ExprKind::UNARY && literal->value_ == "-");
+    if (arithmetic) {
+      Type* current = literal->type_;
+      if (!current || current->kind_ != TypeKind::LITERAL) return;
+      if (current->literal_ != LiteralKind::UNK_INT && current->literal_ != LiteralKind::UNK_FLOAT) return;
+
+      if (literal->kind_ == ExprKind::BINARY) {
+        if (!literal->lhs_ || !literal->rhs_) return;
+        adopt_literal_type(literal->lhs_.get(), type);
+        adopt_literal_type(literal->rhs_.get(), type);
+        literal->type_ = literal->lhs_->type_;
+      } else {
+        if (!literal->nested_) return;
+        adopt_literal_type(literal->nested_.get(), type);
+        literal->type_ = literal->nested_->type_;
+      }
+      return;
+    }
+
+    if (literal->kind_ != ExprKind::LITERAL) return;
+
+    bool number = literal->literal_ == LiteralKind::UNK_INT || literal->literal_ == LiteralKind::UNK_FLOAT;
+    bool target = type->isIntegerType() || type->isFloatType();
+    if (!number || !target || type->literal_ == LiteralKind::UNK_INT) return;
+    // 2.5 does not become an integer
+    if (literal->literal_ == LiteralKind::UNK_FLOAT && !type->isFloatType()) return;
+
+    literal->literal_ = type->literal_;
+    literal->type_->literal_ = type->literal_;
+  }
+
   void SemanticAnalyzer::analyze_type(Type* ty) {
     if (!ty) return;
 
@@ -627,18 +871,29 @@ namespace sonic::frontend {
     return {"", ModuleSource::LOCAL, false};
   }
 
-  std::unique_ptr<ast::Program> SemanticAnalyzer::loadAndAnalyzeModule(const std::string& modulePath) {
+  ast::Program* SemanticAnalyzer::loadAndAnalyzeModule(const std::string& modulePath) {
     if (!sonic::io::is_exists(modulePath) || !sonic::io::is_file(modulePath)) {
       return nullptr;
     }
 
-    std::string content = sonic::io::read_file(modulePath);
-    sonic::frontend::Lexer lexer(content, sonic::io::getFullPath(modulePath));
-    lexer.diag = diag;
+    // a module imported a second time is already declared under groups;
+    // analyzing a fresh copy would stop early and leave it without symbols
+    std::string name = sonic::io::cutPath(sonic::io::getFullPath(modulePath), "src");
+    for (auto pg : astListManager) {
+      if (pg->name_ == name) return pg;
+    }
 
-    sonic::frontend::Parser parser(sonic::io::getFullPath(modulePath), &lexer);
-    parser.diag = diag;
-    std::unique_ptr<ast::Program> program = parser.parse();
+    std::unique_ptr<ast::Program> program = loadCachedModule(modulePath);
+
+    if (!program) {
+      std::string content = sonic::io::read_file(modulePath);
+      sonic::frontend::Lexer lexer(content, sonic::io::getFullPath(modulePath));
+      lexer.diag = diag;
+
+      sonic::frontend::Parser parser(sonic::io::getFullPath(modulePath), &lexer);
+      parser.diag = diag;
+      program = parser.parse();
+    }
 
     if (!program) return nullptr;
 
@@ -648,6 +903,31 @@ namespace sonic::frontend {
     analyzer.entrySymbol = entrySymbol;
     analyzer.analyze(program.get());
 
+    return keep_module(std::move(program));
+  }
+
+  std::string SemanticAnalyzer::getCachePath(const std::string& moduleName) {
+    return sonic::frontend::ast::io::cachePath(moduleName);
+  }
+
+  std::unique_ptr<ast::Program> SemanticAnalyzer::loadCachedModule(const std::string& modulePath) {
+    namespace fs = std::filesystem;
+
+    std::string cacheFile = getCachePath(modulePath) + ".ast";
+    std::error_code ec;
+    auto cacheTime = fs::last_write_time(cacheFile, ec);
+    if (ec) return nullptr;
+    auto sourceTime = fs::last_write_time(modulePath, ec);
+    if (ec || cacheTime < sourceTime) return nullptr;
+
+    // only top-level declarations are decoded here, function bodies follow
+    // in analyze_bodies()
+    auto program = sonic::frontend::ast::io::loadProgramFromFile(cacheFile, true);
+    if (!program) return nullptr;
+
+    // cache entries are keyed by file name only, reject another module's entry
+    if (program->name_ != sonic::io::cutPath(sonic::io::getFullPath(modulePath), "src")) return nullptr;
+
     return program;
   }
 
@@ -664,7 +944,7 @@ namespace sonic::frontend {
       if (entry.is_regular_file() && entry.path().extension() == ".sn") {
         // Parse and analyze each .sn file
         std::string filePath = entry.path().string();
-        std::unique_ptr<ast::Program> module = loadAndAnalyzeModule(filePath);
+        ast::Program* module = loadAndAnalyzeModule(filePath);
 
         if (module && parentSymbol) {
           // Create namespace for this file
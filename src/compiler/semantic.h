@@ -34,7 +34,12 @@ namespace sonic::frontend {
 
     void eager_analyze(ast::Statement* st);
     void analyze_statement(ast::Statement* st);
+    // function bodies a cached module left encoded; call before codegen
+    // when the module has to be compiled again
+    void analyze_bodies(ast::Program* pg);
+    void analyze_block(std::vector<std::unique_ptr<ast::Statement>>& body);
     void analyze_expression(ast::Expression* ex);
+    void adopt_literal_type(ast::Expression* literal, ast::Type* type);
     void analyze_type(ast::Type* ty);
 
     Symbol* lookup_type(ast::Type* ty);
@@ -54,9 +59,15 @@ namespace sonic::frontend {
       bool isDirectory;
     };
 
+    void analyze_body(ast::Statement* st);
+    void analyze_lazy_bodies(std::vector<std::unique_ptr<ast::Statement>>& statements, std::vector<ast::Statement*>& damaged);
+    void reparse_bodies(ast::Program* pg, const std::vector<ast::Statement*>& damaged);
+
     std::string getExternalLibPath();
     ModuleResolution resolveModulePath(const std::vector<std::unique_ptr<ast::Statement>>& qualified);
-    std::unique_ptr<ast::Program> loadAndAnalyzeModule(const std::string& modulePath);
+    ast::Program* loadAndAnalyzeModule(const std::string& modulePath);
+    std::unique_ptr<ast::Program> loadCachedModule(const std::string& modulePath);
+    std::string getCachePath(const std::string& moduleName);
     void loadDirectoryAsNamespace(const std::string& dirPath, Symbol* parentSymbol);
   };
 };
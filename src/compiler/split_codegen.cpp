@@ -0,0 +1,89 @@
+#include "split_codegen.h"
+#include "optimizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+
+namespace sonic::backend {
+  // SplitModule gives every local that ends up shared between partitions
+  // external (hidden) linkage under its own name, so `.str` or a private
+  // function of two split modules would clash in the final link. A suffix
+  // from the module identifier keeps them apart.
+  static void make_locals_unique(llvm::Module& module) {
+    std::string suffix = "." + llvm::utohexstr(llvm::xxh3_64bits(llvm::arrayRefFromStringRef(module.getModuleIdentifier())));
+
+    for (auto& gv : module.global_values()) {
+      if (!gv.hasLocalLinkage()) continue;
+      if (gv.hasName()) gv.setName(gv.getName() + suffix);
+      else gv.setName("__sn_local" + suffix);
+    }
+  }
+
+  bool emit_split_objects(llvm::Module& module, const TargetKey& key, unsigned jobs, std::vector<llvm::SmallVector<char, 0>>& objects) {
+    // a partition without a function body would only cost a thread
+    unsigned defined = 0;
+    for (auto& fn : module) {
+      if (!fn.isDeclaration()) defined++;
+    }
+    unsigned parts = std::max(1u, std::min(jobs, defined));
+
+    make_locals_unique(module);
+
+    // partitions live in their own contexts, so they cross threads as bitcode
+    std::vector<llvm::SmallVector<char, 0>> bitcode;
+    llvm::SplitModule(module, parts, [&](std::unique_ptr<llvm::Module> part) {
+      llvm::SmallVector<char, 0> buffer;
+      llvm::raw_svector_ostream os(buffer);
+      llvm::WriteBitcodeToFile(*part, os);
+      bitcode.push_back(std::move(buffer));
+    });
+
+    objects.clear();
+    objects.resize(bitcode.size());
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+
+    auto worker = [&] {
+      for (size_t i = next++; i < bitcode.size(); i = next++) {
+        llvm::LLVMContext context;
+        llvm::MemoryBufferRef ref(llvm::StringRef(bitcode[i].data(), bitcode[i].size()), module.getModuleIdentifier());
+
+        auto part = llvm::parseBitcodeFile(ref, context);
+        if (!part) {
+          llvm::consumeError(part.takeError());
+          failed = true;
+          continue;
+        }
+
+        llvm::TargetMachine* machine = BackendSession::get().threadTargetMachine(key);
+        llvm::raw_svector_ostream dest(objects[i]);
+
+        llvm::legacy::PassManager pm;
+        if (machine->addPassesToEmitFile(pm, dest, nullptr, llvm::CodeGenFileType::ObjectFile, !verify_ir())) {
+          failed = true;
+          continue;
+        }
+        pm.run(**part);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < bitcode.size(); t++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+
+    return !failed;
+  }
+};
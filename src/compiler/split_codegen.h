@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Module.h>
+
+#include "backend_session.h"
+
+namespace sonic::backend {
+  // splits `module` into at most `jobs` partitions and compiles every one
+  // to an object on its own thread, each with a private LLVMContext and
+  // TargetMachine. Objects are returned in partition order, so the result
+  // does not depend on how the threads were scheduled.
+  bool emit_split_objects(llvm::Module& module, const TargetKey& key, unsigned jobs, std::vector<llvm::SmallVector<char, 0>>& objects);
+};
@@ -0,0 +1,103 @@
+#include "ssa_builder.h"
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
+
+namespace sonic::backend {
+  void SSABuilder::declare(Symbol* var, llvm::Type* type) {
+    types_[var] = type;
+  }
+
+  void SSABuilder::writeVariable(Symbol* var, llvm::BasicBlock* block, llvm::Value* value) {
+    current_[block][var] = value;
+  }
+
+  llvm::Value* SSABuilder::readVariable(Symbol* var, llvm::BasicBlock* block) {
+    auto defs = current_.find(block);
+    if (defs != current_.end()) {
+      auto found = defs->second.find(var);
+      if (found != defs->second.end() && found->second) return found->second;
+    }
+    return readVariableRecursive(var, block);
+  }
+
+  llvm::Value* SSABuilder::readVariableRecursive(Symbol* var, llvm::BasicBlock* block) {
+    llvm::Value* value;
+    if (!sealed_.count(block)) {
+      // predecessors still unknown, completed by sealBlock()
+      auto phi = createPhi(var, block);
+      incomplete_[block].emplace_back(var, phi);
+      value = phi;
+    } else if (auto pred = block->getUniquePredecessor()) {
+      value = readVariable(var, pred);
+    } else if (llvm::pred_empty(block)) {
+      // read before any definition
+      value = llvm::PoisonValue::get(types_.at(var));
+    } else {
+      // the phi is written first so a loop back to this block finds it
+      auto phi = createPhi(var, block);
+      writeVariable(var, block, phi);
+      value = addPhiOperands(var, phi);
+    }
+    writeVariable(var, block, value);
+    return value;
+  }
+
+  llvm::PHINode* SSABuilder::createPhi(Symbol* var, llvm::BasicBlock* block) {
+    llvm::IRBuilder<> builder(block, block->begin());
+    return builder.CreatePHI(types_.at(var), 2, var->name_);
+  }
+
+  llvm::Value* SSABuilder::addPhiOperands(Symbol* var, llvm::PHINode* phi) {
+    // one entry per edge, a block branching here twice is listed twice
+    for (auto pred : llvm::predecessors(phi->getParent())) {
+      phi->addIncoming(readVariable(var, pred), pred);
+    }
+    return tryRemoveTrivialPhi(phi);
+  }
+
+  llvm::Value* SSABuilder::tryRemoveTrivialPhi(llvm::PHINode* phi) {
+    llvm::Value* same = nullptr;
+    for (llvm::Value* op : phi->incoming_values()) {
+      if (op == same || op == phi) continue;
+      // merges at least two values
+      if (same) return phi;
+      same = op;
+    }
+    // unreachable or only reached from itself
+    if (!same) same = llvm::PoisonValue::get(phi->getType());
+
+    // phis using this one may become trivial once it is gone
+    llvm::SmallVector<llvm::WeakVH, 8> users;
+    for (auto user : phi->users()) {
+      if (user != phi && llvm::isa<llvm::PHINode>(user)) users.emplace_back(user);
+    }
+
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+
+    for (auto& user : users) {
+      if (auto userPhi = llvm::dyn_cast_or_null<llvm::PHINode>(user)) tryRemoveTrivialPhi(userPhi);
+    }
+    return same;
+  }
+
+  void SSABuilder::sealBlock(llvm::BasicBlock* block) {
+    auto found = incomplete_.find(block);
+    if (found != incomplete_.end()) {
+      auto phis = std::move(found->second);
+      incomplete_.erase(found);
+      for (auto& [var, phi] : phis) addPhiOperands(var, phi);
+    }
+    sealed_.insert(block);
+  }
+
+  void SSABuilder::clear() {
+    types_.clear();
+    current_.clear();
+    incomplete_.clear();
+    sealed_.clear();
+  }
+};
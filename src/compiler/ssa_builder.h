@@ -0,0 +1,59 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/Value.h>
+#include <llvm/IR/ValueHandle.h>
+
+#include "symbol.h"
+
+using namespace sonic::frontend;
+
+namespace sonic::backend {
+  // on-the-fly SSA construction for the locals of one function, after
+  // Braun et al., "Simple and Efficient Construction of Static Single
+  // Assignment Form" (CC 2013). Variables live in registers instead of
+  // allocas; a read walks up the predecessors and places phis only where
+  // definitions meet. A block is sealed once all of its predecessors are
+  // known, reads in unsealed blocks get a placeholder phi that is
+  // completed on sealing. Trivial phis are removed as they appear, so the
+  // result needs no mem2reg.
+  class SSABuilder {
+    public:
+    // starts tracking `var`; values written for it must be of `type`
+    void declare(Symbol* var, llvm::Type* type);
+    // type of a tracked variable, null for variables kept in memory
+    llvm::Type* typeOf(Symbol* var) const {
+      auto found = types_.find(var);
+      return found != types_.end() ? found->second : nullptr;
+    }
+
+    void writeVariable(Symbol* var, llvm::BasicBlock* block, llvm::Value* value);
+    llvm::Value* readVariable(Symbol* var, llvm::BasicBlock* block);
+
+    // no predecessors will be added to `block` anymore
+    void sealBlock(llvm::BasicBlock* block);
+
+    // forget the previous function
+    void clear();
+
+    private:
+    std::unordered_map<Symbol*, llvm::Type*> types_;
+    // latest definition of each variable per block; phis removed as
+    // trivial are replaced in place through the handle
+    std::unordered_map<llvm::BasicBlock*, std::unordered_map<Symbol*, llvm::WeakTrackingVH>> current_;
+    std::unordered_map<llvm::BasicBlock*, std::vector<std::pair<Symbol*, llvm::PHINode*>>> incomplete_;
+    std::unordered_set<llvm::BasicBlock*> sealed_;
+
+    llvm::Value* readVariableRecursive(Symbol* var, llvm::BasicBlock* block);
+    llvm::PHINode* createPhi(Symbol* var, llvm::BasicBlock* block);
+    llvm::Value* addPhiOperands(Symbol* var, llvm::PHINode* phi);
+    llvm::Value* tryRemoveTrivialPhi(llvm::PHINode* phi);
+  };
+};
@@ -27,6 +27,8 @@ namespace sonic::frontend {
     ENUM,
     VARIABLE,
     ALIAS,
+    // scope of an `if` / `while` body
+    BLOCK,
     UNKNOWN,
   };
 
@@ -36,6 +38,7 @@ namespace sonic::frontend {
       case sonic::frontend::SymbolKind::FUNCTION: return "function";
       case sonic::frontend::SymbolKind::VARIABLE: return "variable";
       case sonic::frontend::SymbolKind::ALIAS: return "alias";
+      case sonic::frontend::SymbolKind::BLOCK: return "block";
       default: return "unknown";
     }
   }
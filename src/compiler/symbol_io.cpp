@@ -5,18 +5,29 @@
 
 namespace sonic::frontend::symbol::io {
 
-bool saveSymbolToFile(const Symbol& program, const std::string& path) {
-    nlohmann::json j = symbolToJson((Symbol*)&program);
-
-    std::ofstream file(path);
+bool saveSymbolToFile(const Symbol& program, const std::string& path, bool compact) {
+    sonic::io::JsonWriter file(path, !compact);
     if (!file.is_open()) {
         return false;
     }
 
-    file << j.dump(2);
-    file.close();
+    symbolToJson((Symbol*)&program, file);
+
+    return file.close();
+}
+
+Symbol* loadSymbolFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+
+    nlohmann::json j = nlohmann::json::parse(file, nullptr, false);
+    if (j.is_discarded()) {
+        return nullptr;
+    }
 
-    return true;
+    return jsonToSymbol(j);
 }
 
 }
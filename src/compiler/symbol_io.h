@@ -6,6 +6,7 @@
 
 namespace sonic::frontend::symbol::io {
 
-bool saveSymbolToFile(const Symbol& program, const std::string& path);
+bool saveSymbolToFile(const Symbol& program, const std::string& path, bool compact = false);
+Symbol* loadSymbolFromFile(const std::string& path);
 
 }
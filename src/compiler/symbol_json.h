@@ -1,88 +1,215 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include "symbol.h"
 #include "ast_json.h"
 #include "ast.h"
+#include "json_writer.h"
 
+// Symbol graphs are written flat: every reachable symbol once, in a stable
+// order, with parent / children / ref stored as indices into "symbols".
+//
+//   { "version": 2, "root": 0, "symbols": [ { "id": 0, ..., "parent": null,
+//     "children": [1, 2], "ref": null }, ... ] }
 namespace sonic::frontend {
   using namespace ast::json;
 
-  inline nlohmann::json symbolToJson(Symbol* sym) {
-    if (!sym) return nullptr;
+  constexpr int SYMBOL_GRAPH_VERSION = 2;
+
+  // ids follow the order symbols are first reached: the root, its children
+  // in declaration order, then any parent / ref target outside that tree
+  struct SymbolGraph {
+    std::vector<Symbol*> symbols;
+    std::unordered_map<Symbol*, size_t> ids;
+
+    explicit SymbolGraph(Symbol* root) {
+      add(root);
+      for (size_t i = 0; i < symbols.size(); i++) {
+        Symbol* sym = symbols[i];
+        for (auto& child : sym->children_) add(child);
+        add(sym->parent_);
+        add(sym->ref_);
+      }
+    }
 
-    nlohmann::json j;
-    j["name"] = sym->name_;
-    j["mangle"] = sym->mangle_;
-    j["kind"] = static_cast<int>(sym->kind_);
-    j["scope"] = static_cast<int>(sym->scope_);
-    j["public"] = sym->public_;
-    j["extern"] = sym->extern_;
-    j["async"] = sym->async_;
-    j["decl"] = sym->decl_;
-    j["variadic"] = sym->variadic_;
-    j["mutability"] = static_cast<int>(sym->mutability_);
-    j["parent"] = symbolToJson(sym->parent_);
-    j["type"] = sym->type_ ? ast::json::serializeType(*sym->type_) : nullptr;
-
-    // Parameters
-    for (auto& param : sym->params_) {
-      j["params"].push_back(ast::json::serializeType(*param));
+    void add(Symbol* sym) {
+      if (!sym || ids.count(sym)) return;
+      ids.emplace(sym, symbols.size());
+      symbols.push_back(sym);
     }
 
-    // Children
-    j["children"] = nlohmann::json::array();
-    for (auto& child : sym->children_) {
-      j["children"].push_back(symbolToJson(child));
+    nlohmann::json idOf(Symbol* sym) const {
+      if (!sym) return nullptr;
+      return ids.at(sym);
     }
+  };
 
-    j["ref"] = symbolToJson(sym->ref_);
+  inline nlohmann::json symbolToJson(Symbol* root) {
+    if (!root) return nullptr;
+
+    SymbolGraph graph(root);
+
+    nlohmann::json j;
+    j["version"] = SYMBOL_GRAPH_VERSION;
+    j["root"] = 0;
+    j["symbols"] = nlohmann::json::array();
+
+    for (size_t id = 0; id < graph.symbols.size(); id++) {
+      Symbol* sym = graph.symbols[id];
+
+      nlohmann::json s;
+      s["id"] = id;
+      s["name"] = sym->name_;
+      s["mangle"] = sym->mangle_;
+      s["kind"] = static_cast<int>(sym->kind_);
+      s["scope"] = static_cast<int>(sym->scope_);
+      s["public"] = sym->public_;
+      s["extern"] = sym->extern_;
+      s["async"] = sym->async_;
+      s["decl"] = sym->decl_;
+      s["variadic"] = sym->variadic_;
+      s["mutability"] = static_cast<int>(sym->mutability_);
+      s["type"] = sym->type_ ? ast::json::serializeType(*sym->type_) : nullptr;
+
+      // Parameters
+      s["params"] = nlohmann::json::array();
+      for (auto& param : sym->params_) {
+        s["params"].push_back(ast::json::serializeType(*param));
+      }
+
+      // Links
+      s["parent"] = graph.idOf(sym->parent_);
+      s["ref"] = graph.idOf(sym->ref_);
+      s["children"] = nlohmann::json::array();
+      for (auto& child : sym->children_) {
+        s["children"].push_back(graph.idOf(child));
+      }
+
+      j["symbols"].push_back(std::move(s));
+    }
 
     return j;
   }
 
-  inline Symbol* jsonToSymbol(const nlohmann::json& j) {
-    if (j.is_null()) return nullptr;
-
-    Symbol* sym = new Symbol();
-    sym->name_ = j.value("name", "");
-    sym->mangle_ = j.value("mangle", "");
-    sym->kind_ = static_cast<SymbolKind>(j.value("kind", 0));
-    sym->scope_ = static_cast<ScopeLevel>(j.value("scope", 0));
-    sym->public_ = j.value("public", 0);
-    sym->extern_ = j.value("extern", 0);
-    sym->async_ = j.value("async_", 0);
-    sym->decl_ = j.value("decl", false);
-    sym->variadic_ = j.value("variadic", false);
-    sym->mutability_ = static_cast<ast::Mutability>(j.value("mutability", 0));
-    sym->parent_ = jsonToSymbol(j.value("parent", nullptr));
-
-    if (j.contains("type") && !j["type"].is_null()) {
-      sym->type_ = ast::json::deserializeType(j["type"]).release();
+  // streaming variant of symbolToJson, same layout
+  inline void symbolToJson(Symbol* root, sonic::io::JsonWriter& w) {
+    if (!root) {
+      w.null();
+      return;
     }
 
-    // Parameters
-    if (j.contains("params")) {
-      for (auto& paramJson : j["params"]) {
-        auto paramType = ast::json::deserializeType(paramJson);
-        sym->params_.push_back(paramType.release());
-      }
+    SymbolGraph graph(root);
+
+    auto link = [&](const char* key, Symbol* sym) {
+      w.key(key);
+      if (sym) w.value(graph.ids.at(sym));
+      else w.null();
+    };
+
+    w.beginObject();
+    w.field("version", SYMBOL_GRAPH_VERSION);
+    w.field("root", 0);
+    w.key("symbols");
+    w.beginArray();
+
+    for (size_t id = 0; id < graph.symbols.size(); id++) {
+      Symbol* sym = graph.symbols[id];
+
+      w.beginObject();
+      w.field("id", id);
+      w.field("name", sym->name_);
+      w.field("mangle", sym->mangle_);
+      w.field("kind", static_cast<int>(sym->kind_));
+      w.field("scope", static_cast<int>(sym->scope_));
+      w.field("public", sym->public_);
+      w.field("extern", sym->extern_);
+      w.field("async", sym->async_);
+      w.field("decl", sym->decl_);
+      w.field("variadic", sym->variadic_);
+      w.field("mutability", static_cast<int>(sym->mutability_));
+
+      w.key("type");
+      if (sym->type_) ast::json::serializeType(*sym->type_, w);
+      else w.null();
+
+      // Parameters
+      w.key("params");
+      w.beginArray();
+      for (auto& param : sym->params_) ast::json::serializeType(*param, w);
+      w.endArray();
+
+      // Links
+      link("parent", sym->parent_);
+      link("ref", sym->ref_);
+      w.key("children");
+      w.beginArray();
+      for (auto& child : sym->children_) w.value(graph.ids.at(child));
+      w.endArray();
+
+      w.endObject();
     }
 
-    // Children
-    if (j.contains("children")) {
-      for (auto& childJson : j["children"]) {
-        Symbol* childSym = jsonToSymbol(childJson);
-        if (childSym) {
-          sym->children_.push_back(childSym);
+    w.endArray();
+    w.endObject();
+  }
+
+  // rebuilds the graph in a single pass over "symbols"; links may point
+  // forward, so every node is allocated up front
+  inline Symbol* jsonToSymbol(const nlohmann::json& j) {
+    if (j.is_null() || !j.contains("symbols")) return nullptr;
+    if (j.value("version", 0) != SYMBOL_GRAPH_VERSION) return nullptr;
+
+    const auto& entries = j["symbols"];
+    std::vector<Symbol*> table(entries.size());
+    for (auto& sym : table) sym = new Symbol();
+
+    auto link = [&](const nlohmann::json& id) -> Symbol* {
+      if (!id.is_number_integer()) return nullptr;
+      int64_t index = id.get<int64_t>();
+      if (index < 0 || static_cast<size_t>(index) >= table.size()) return nullptr;
+      return table[index];
+    };
+
+    for (size_t i = 0; i < entries.size(); i++) {
+      const auto& s = entries[i];
+      Symbol* sym = table[i];
+
+      sym->name_ = s.value("name", "");
+      sym->mangle_ = s.value("mangle", "");
+      sym->kind_ = static_cast<SymbolKind>(s.value("kind", 0));
+      sym->scope_ = static_cast<ScopeLevel>(s.value("scope", 0));
+      sym->public_ = s.value("public", false);
+      sym->extern_ = s.value("extern", false);
+      sym->async_ = s.value("async", false);
+      sym->decl_ = s.value("decl", false);
+      sym->variadic_ = s.value("variadic", false);
+      sym->mutability_ = static_cast<ast::Mutability>(s.value("mutability", 0));
+
+      if (s.contains("type") && !s["type"].is_null()) {
+        sym->type_ = ast::json::deserializeType(s["type"]).release();
+      }
+
+      // Parameters
+      if (s.contains("params")) {
+        for (auto& paramJson : s["params"]) {
+          sym->params_.push_back(ast::json::deserializeType(paramJson).release());
         }
       }
-    }
 
-    sym->ref_ = jsonToSymbol(j.value("ref", nullptr));
+      // Links
+      if (s.contains("parent")) sym->parent_ = link(s["parent"]);
+      if (s.contains("ref")) sym->ref_ = link(s["ref"]);
+      if (s.contains("children")) {
+        for (auto& id : s["children"]) {
+          if (Symbol* child = link(id)) sym->children_.push_back(child);
+        }
+      }
+    }
 
-    return sym;
+    return link(j.value("root", nlohmann::json(0)));
   }
 
 }
@@ -56,6 +56,7 @@ enum class TokenType {
   TRY,
   CATCH,
   FINALLY,
+  RESTRICT,
 
   LEFTPAREN,
   RIGHTPAREN,
@@ -146,6 +147,7 @@ inline std::string tokenTypeToValue(TokenType t) {
     case TokenType::TRY:       return "try";
     case TokenType::CATCH:       return "catch";
     case TokenType::FINALLY:       return "finally";
+    case TokenType::RESTRICT:      return "restrict";
 
 
     // types
@@ -262,6 +264,7 @@ const std::unordered_map<std::string, TokenType> keywords = {
   {"try", TokenType::TRY},
   {"catch", TokenType::CATCH},
   {"finally", TokenType::FINALLY},
+  {"restrict", TokenType::RESTRICT},
 };
 
 const std::unordered_map<std::string, TokenType> punctuation = {
@@ -293,6 +296,8 @@ const std::unordered_map<std::string, TokenType> punctuation = {
   {"->", TokenType::ARROW},
 
   // math
+  {"**=",TokenType::POWER_EQUAL},
+  {"**", TokenType::POWER},
   {"^=",TokenType::POWER_EQUAL},
   {"^", TokenType::POWER},
   {"+=", TokenType::PLUS_EQUAL},
@@ -0,0 +1,50 @@
+#include "type_alias.h"
+
+#include <llvm/IR/LLVMContext.h>
+
+namespace sonic::backend {
+  TypeAliasInfo::TypeAliasInfo(llvm::LLVMContext& context) : md_(context) {
+    llvm::MDNode* root = md_.createTBAARoot("Sonic TBAA");
+    char_ = md_.createTBAAScalarTypeNode("omnipotent char", root);
+  }
+
+  llvm::MDNode* TypeAliasInfo::accessTag(ast::Type* type) {
+    if (!type) return nullptr;
+
+    switch (type->kind_) {
+      case ast::TypeKind::PTR:
+      case ast::TypeKind::REF: return tag("any pointer");
+      case ast::TypeKind::LITERAL: {
+        switch (type->literal_) {
+          case ast::LiteralKind::BOOL: return tag("bool");
+          case ast::LiteralKind::CHAR: return tag("omnipotent char");
+          case ast::LiteralKind::I32: return tag("i32");
+          // untyped integers are lowered as i64
+          case ast::LiteralKind::UNK_INT:
+          case ast::LiteralKind::I64: return tag("i64");
+          case ast::LiteralKind::I128: return tag("i128");
+          case ast::LiteralKind::F32: return tag("f32");
+          case ast::LiteralKind::F64: return tag("f64");
+          case ast::LiteralKind::STRING: return tag("any pointer");
+          default: return nullptr;
+        }
+      }
+      default: return nullptr;
+    }
+  }
+
+  void TypeAliasInfo::attach(llvm::Instruction* access, ast::Type* type) {
+    if (!access) return;
+    if (llvm::MDNode* node = accessTag(type)) access->setMetadata(llvm::LLVMContext::MD_tbaa, node);
+  }
+
+  llvm::MDNode* TypeAliasInfo::tag(const std::string& name) {
+    auto found = tags_.find(name);
+    if (found != tags_.end()) return found->second;
+
+    llvm::MDNode* node = name == "omnipotent char" ? char_ : md_.createTBAAScalarTypeNode(name, char_);
+    llvm::MDNode* access = md_.createTBAAStructTagNode(node, node, 0);
+    tags_.emplace(name, access);
+    return access;
+  }
+};
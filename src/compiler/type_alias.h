@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <llvm/IR/Instruction.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/Metadata.h>
+
+#include "ast.h"
+
+using namespace sonic::frontend;
+
+namespace sonic::backend {
+  // TBAA type tree of one module, derived from ast::Type. Sonic has no
+  // casts between pointer types, so memory written as one scalar type is
+  // never read as another and accesses of different types do not alias:
+  //
+  //   "Sonic TBAA" <- "omnipotent char" <- bool, i32, i64, i128, f32, f64, any pointer
+  //
+  // char accesses may alias anything, like in C, so byte buffers stay safe
+  // to pass to and from extern code.
+  class TypeAliasInfo {
+    public:
+    explicit TypeAliasInfo(llvm::LLVMContext& context);
+
+    // tag for a load or store of `type`; null when the type has no node
+    llvm::MDNode* accessTag(ast::Type* type);
+    void attach(llvm::Instruction* access, ast::Type* type);
+
+    private:
+    llvm::MDBuilder md_;
+    llvm::MDNode* char_ = nullptr;
+    std::unordered_map<std::string, llvm::MDNode*> tags_;
+
+    llvm::MDNode* tag(const std::string& name);
+  };
+};
@@ -2,7 +2,9 @@
 #define SONIC_CONFIG_H
 
 // c++ library
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace sonic::config {
 
@@ -15,6 +17,9 @@ namespace sonic::config {
 
   inline bool is_compiled = false;
 
+  // write --debug JSON dumps without indentation
+  inline bool json_compact = false;
+
   enum OptLevel {
     NO,
     O2,
@@ -23,6 +28,67 @@ namespace sonic::config {
   };
   inline OptLevel optimizer_level = OptLevel::O2;
 
+  // --profile=dev: tuned for the edit-compile-run loop, -O0 with FastISel
+  // and the fast register allocator, every core, no IR verifier in release
+  // builds of sonic, and a compile latency report
+  enum BuildProfile {
+    PROFILE_DEFAULT,
+    PROFILE_DEV,
+  };
+  inline BuildProfile build_profile = PROFILE_DEFAULT;
+
+  // report per-pass timings of the LLVM pipeline (--time-passes)
+  inline bool time_passes = false;
+
+  // artifacts written for each module (--emit=obj,asm,bc,ll)
+  enum EmitKind {
+    EMIT_OBJ = 1 << 0,
+    EMIT_ASM = 1 << 1,
+    EMIT_BC  = 1 << 2,
+    EMIT_LL  = 1 << 3,
+  };
+  inline unsigned emit_kinds = EMIT_OBJ;
+
+  // backend threads per module; above 1 the module is split into
+  // partitions that are compiled to separate objects (-j N)
+  inline unsigned codegen_jobs = 1;
+
+  // debug metadata: -gline-tables-only for profilers, -g for debuggers
+  enum DebugInfoLevel {
+    DEBUG_NONE,
+    DEBUG_LINE_TABLES,
+    DEBUG_FULL,
+  };
+  inline DebugInfoLevel debug_info = DEBUG_NONE;
+
+  // link time optimization across modules (--lto=thin|full)
+  enum LtoMode {
+    LTO_NONE,
+    LTO_THIN,
+    LTO_FULL,
+  };
+  inline LtoMode lto_mode = LTO_NONE;
+
+  // profile guided optimization: --profile-generate[=<dir>] instruments
+  // the program to write <dir>/default_<id>.profraw (build/profile by
+  // default), --profile-use=<file> optimizes with a merged profile
+  inline bool profile_generate = false;
+  inline std::string profile_dir;
+  inline std::string profile_use;
+
+  // machine code cache of `sonic run` (build/cache/jit)
+  inline bool jit_cache = true;
+  inline uint64_t jit_cache_limit = 256ull << 20;
+
+  // compiled objects of `sonic build` (build/cache/objects)
+  inline bool object_cache = true;
+  inline uint64_t object_cache_limit = 1ull << 30;
+
+  inline bool cache_stats = false;
+
+  // `sonic run --hot`: reload changed functions while the program runs
+  inline bool hot_reload = false;
+
   // ===============================
   // Runtime project state
   // ===============================
@@ -33,6 +99,13 @@ namespace sonic::config {
   inline std::string config_file;
   inline std::string output_name;
   inline std::string target_platform;
+  // --target a,b: every triple of a fat build, target_platform is the first
+  inline std::vector<std::string> target_platforms;
+
+  // --cpu=native|<name> and --features=+avx2,...; without --cpu host
+  // builds use the host CPU and cross builds a baseline for the triple
+  inline std::string target_cpu;
+  inline std::string target_features;
 
   // ===============================
   // App metadata
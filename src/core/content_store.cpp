@@ -0,0 +1,90 @@
+// c++ library
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// local header
+#include "content_store.h"
+#include "io.h"
+
+namespace fs = std::filesystem;
+
+namespace sonic::io {
+
+  ContentStore::ContentStore(std::string dir, uint64_t limit)
+  : dir_(std::move(dir)), limit_(limit) {}
+
+  std::string ContentStore::pathFor(const std::string& key) const {
+    // two-level fan-out keeps directories small
+    if (key.size() <= 2) return dir_ + "/" + key;
+    return dir_ + "/" + key.substr(0, 2) + "/" + key.substr(2);
+  }
+
+  bool ContentStore::contains(const std::string& key) const {
+    std::error_code ec;
+    return fs::is_regular_file(pathFor(key), ec);
+  }
+
+  bool ContentStore::load(const std::string& key, std::string& out) {
+    std::string path = pathFor(key);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+      misses_++;
+      return false;
+    }
+
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+      misses_++;
+      return false;
+    }
+
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    hits_++;
+    return true;
+  }
+
+  bool ContentStore::store(const std::string& key, std::string_view content) {
+    std::string path = pathFor(key);
+
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    if (ec) return false;
+
+    return write_file_atomic(path, content);
+  }
+
+  void ContentStore::trim() {
+    struct Entry {
+      fs::file_time_type time;
+      uintmax_t size;
+      fs::path path;
+    };
+
+    std::error_code ec;
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+
+    for (auto it = fs::recursive_directory_iterator(dir_, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+      if (!it->is_regular_file(ec) || it->path().extension() == ".tmp") continue;
+
+      Entry entry{it->last_write_time(ec), it->file_size(ec), it->path()};
+      if (ec) continue;
+      total += entry.size;
+      entries.push_back(std::move(entry));
+    }
+
+    if (total <= limit_) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+      return a.time < b.time;
+    });
+
+    for (auto& entry : entries) {
+      if (total <= limit_) break;
+      if (fs::remove(entry.path, ec)) total -= entry.size;
+    }
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// c++ library
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sonic::io {
+
+  // directory of immutable entries named by a content hash (hex). Entries
+  // are written atomically, so concurrent builds can share a store; a hit
+  // refreshes the entry's mtime, which makes trim() evict the least
+  // recently used entries first.
+  class ContentStore {
+    public:
+    ContentStore(std::string dir, uint64_t limit);
+
+    // false when `key` is not in the store
+    bool load(const std::string& key, std::string& out);
+    bool store(const std::string& key, std::string_view content);
+    bool contains(const std::string& key) const;
+
+    // evict least recently used entries until the store fits in `limit`
+    void trim();
+
+    std::string pathFor(const std::string& key) const;
+    const std::string& dir() const { return dir_; }
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+    private:
+    std::string dir_;
+    uint64_t limit_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+  };
+}
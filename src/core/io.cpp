@@ -1,10 +1,20 @@
 // c++ library
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <random>
 
 // local header
 #include "io.h"
+#include "platform.h"
+
+#if !defined(TARGET_OS_WINDOWS)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -157,4 +167,70 @@ namespace sonic::io {
     return path.substr(pos);
   }
 
+  bool write_file_atomic(const std::string& path, std::string_view content) {
+    // unique per writer, so concurrent writers of one path never share it
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+    char suffix[24];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(rng()));
+    std::string tmp = path + suffix;
+
+    {
+      ofstream file(tmp, ios::out | ios::binary | ios::trunc);
+      if (!file.is_open()) {
+        std::cerr << "\033[31merror:\033[0m failed to open file '" << tmp << "'";
+        return false;
+      }
+      file.write(content.data(), content.size());
+      if (!file.good()) return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+      fs::remove(tmp, ec);
+      return false;
+    }
+    return true;
+  }
+
+  std::shared_ptr<MappedFile> MappedFile::open(const std::string& path) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+
+#if !defined(TARGET_OS_WINDOWS)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      return nullptr;
+    }
+
+    file->size_ = static_cast<size_t>(st.st_size);
+    if (file->size_ > 0) {
+      void* addr = mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+      }
+      file->data_ = static_cast<const uint8_t*>(addr);
+    }
+    ::close(fd);
+#else
+    ifstream in(path, ios::in | ios::binary);
+    if (!in.is_open()) return nullptr;
+    file->fallback_.assign((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    file->data_ = reinterpret_cast<const uint8_t*>(file->fallback_.data());
+    file->size_ = file->fallback_.size();
+#endif
+
+    return file;
+  }
+
+  MappedFile::~MappedFile() {
+#if !defined(TARGET_OS_WINDOWS)
+    if (data_ && size_ > 0) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+  }
+
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 // c++ library
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
@@ -24,4 +28,28 @@ namespace sonic::io {
   std::string getPathWithoutFile(const std::string& path);
   std::string getFullPath(const std::string& path);
   std::string cutPath(const std::string& path, const std::string& prefix);
+
+  // write to a sibling temp file and rename it over `path`, so readers
+  // (including live mappings of the old file) never observe a partial write
+  bool write_file_atomic(const std::string& path, std::string_view content);
+
+  // read-only view of a whole file, memory mapped where the platform allows
+  class MappedFile {
+    public:
+    static std::shared_ptr<MappedFile> open(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    private:
+    MappedFile() = default;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::string fallback_;
+  };
 }
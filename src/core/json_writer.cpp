@@ -0,0 +1,161 @@
+// c++ library
+#include <algorithm>
+#include <iostream>
+
+// local header
+#include "json_writer.h"
+
+namespace sonic::io {
+
+  JsonWriter::JsonWriter(const std::string& path, bool pretty) : pretty_(pretty) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+      std::cerr << "\033[31merror:\033[0m failed to open file '" << path << "'";
+      return;
+    }
+    buffer_.reserve(BUFFER_SIZE);
+  }
+
+  JsonWriter::~JsonWriter() {
+    close();
+  }
+
+  bool JsonWriter::close() {
+    if (!file_) return !failed_;
+
+    flush();
+    if (std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+  }
+
+  void JsonWriter::beginObject() {
+    beginValue();
+    write('{');
+    empty_.push_back(true);
+  }
+
+  void JsonWriter::endObject() {
+    endContainer('}');
+  }
+
+  void JsonWriter::beginArray() {
+    beginValue();
+    write('[');
+    empty_.push_back(true);
+  }
+
+  void JsonWriter::endArray() {
+    endContainer(']');
+  }
+
+  void JsonWriter::key(std::string_view k) {
+    beginValue();
+    writeEscaped(k);
+    write(pretty_ ? ": " : ":");
+    after_key_ = true;
+  }
+
+  void JsonWriter::value(std::string_view s) {
+    beginValue();
+    writeEscaped(s);
+  }
+
+  void JsonWriter::writeEscaped(std::string_view s) {
+    write('"');
+
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+      unsigned char c = s[i];
+      const char* esc = nullptr;
+      char hex[7];
+
+      switch (c) {
+        case '"':  esc = "\\\""; break;
+        case '\\': esc = "\\\\"; break;
+        case '\b': esc = "\\b"; break;
+        case '\f': esc = "\\f"; break;
+        case '\n': esc = "\\n"; break;
+        case '\r': esc = "\\r"; break;
+        case '\t': esc = "\\t"; break;
+        default:
+          if (c < 0x20) {
+            std::snprintf(hex, sizeof(hex), "\\u%04x", c);
+            esc = hex;
+          }
+      }
+
+      if (esc) {
+        write(s.substr(run, i - run));
+        write(esc);
+        run = i + 1;
+      }
+    }
+    write(s.substr(run));
+
+    write('"');
+  }
+
+  void JsonWriter::value(bool b) {
+    beginValue();
+    write(b ? "true" : "false");
+  }
+
+  void JsonWriter::null() {
+    beginValue();
+    write("null");
+  }
+
+  void JsonWriter::beginValue() {
+    if (after_key_) {
+      after_key_ = false;
+      return;
+    }
+    if (empty_.empty()) return;
+
+    if (!empty_.back()) write(',');
+    empty_.back() = false;
+    newline();
+  }
+
+  void JsonWriter::endContainer(char close) {
+    bool wasEmpty = empty_.back();
+    empty_.pop_back();
+    if (!wasEmpty) newline();
+    write(close);
+  }
+
+  void JsonWriter::newline() {
+    if (!pretty_) return;
+    static const std::string spaces(128, ' ');
+    write('\n');
+    for (size_t n = empty_.size() * 2; n > 0; ) {
+      size_t chunk = std::min(n, spaces.size());
+      write(std::string_view(spaces.data(), chunk));
+      n -= chunk;
+    }
+  }
+
+  void JsonWriter::write(std::string_view s) {
+    if (buffer_.size() + s.size() > BUFFER_SIZE) flush();
+    if (s.size() > BUFFER_SIZE) {
+      if (file_ && std::fwrite(s.data(), 1, s.size(), file_) != s.size()) failed_ = true;
+      return;
+    }
+    buffer_.append(s.data(), s.size());
+  }
+
+  void JsonWriter::write(char c) {
+    if (buffer_.size() + 1 > BUFFER_SIZE) flush();
+    buffer_.push_back(c);
+  }
+
+  void JsonWriter::flush() {
+    if (!file_ || buffer_.empty()) {
+      buffer_.clear();
+      return;
+    }
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) failed_ = true;
+    buffer_.clear();
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// c++ library
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace sonic::io {
+
+  // SAX-style JSON writer that streams into a fixed-size buffer and flushes
+  // it to the file, so memory stays bounded by the nesting depth instead of
+  // the document size. Pretty output matches nlohmann's dump(2) layout.
+  class JsonWriter {
+    public:
+    JsonWriter(const std::string& path, bool pretty = true);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    bool is_open() const { return file_ != nullptr; }
+
+    // flush and close; false when any write failed
+    bool close();
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    void key(std::string_view k);
+
+    void value(std::string_view s);
+    void value(const std::string& s) { value(std::string_view(s)); }
+    void value(const char* s) { value(std::string_view(s)); }
+    void value(bool b);
+    void null();
+
+    template<typename T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>> value(T v) {
+      char buf[24];
+      auto res = std::to_chars(buf, buf + sizeof(buf), v);
+      beginValue();
+      write(std::string_view(buf, res.ptr - buf));
+    }
+
+    template<typename T>
+    void field(std::string_view k, const T& v) {
+      key(k);
+      value(v);
+    }
+
+    private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    std::FILE* file_ = nullptr;
+    std::string buffer_;
+    bool pretty_;
+    bool failed_ = false;
+    bool after_key_ = false;
+
+    // one entry per open container: true until its first element is written
+    std::vector<bool> empty_;
+
+    void beginValue();
+    void endContainer(char close);
+    void newline();
+    void writeEscaped(std::string_view s);
+    void write(std::string_view s);
+    void write(char c);
+    void flush();
+  };
+}
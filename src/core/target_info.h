@@ -46,7 +46,7 @@ inline std::string target_cpu(const std::string& target_triple) {
 
   // Linux
   if (target_triple.find("linux") != std::string::npos) {
-      if (target_triple.find("x86_64") != std::string::npos) return "generic"; // atau tigerlake jika native
+      if (target_triple.find("x86_64") != std::string::npos) return "x86-64";
       if (target_triple.find("aarch64") != std::string::npos) return "generic";
   }
 
@@ -59,7 +59,7 @@ inline std::string target_cpu(const std::string& target_triple) {
   // Apple / macOS / iOS
   if (target_triple.find("apple") != std::string::npos) {
       if (target_triple.find("x86_64") != std::string::npos) return "core2"; // default Apple x86
-      if (target_triple.find("arm64") != std::string::npos) return "generic";
+      if (target_triple.find("arm64") != std::string::npos) return "apple-m1";
   }
 
   // fallback
@@ -1,6 +1,11 @@
 // c++ library
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
 
 // local header
 #include "../core/config.h"
@@ -14,6 +19,13 @@
 #include "../compiler/diagnostics.h"
 #include "semantic.h"
 #include "../compiler/codegen.h"
+#include "../compiler/hot_reload.h"
+#include "../compiler/jit.h"
+#include "../compiler/linker.h"
+#include "../compiler/lto.h"
+#include "../compiler/profile.h"
+
+#include <llvm/IR/PassTimingInfo.h>
 
 namespace cfg = sonic::config;
 using namespace sonic::frontend;
@@ -25,7 +37,8 @@ R"(sonic - Simple Programming Language
 Usage:
   sonic new <project_name>
   sonic compile [options]
-  sonic run
+  sonic run [options]
+  sonic merge-profiles <out.profdata> <profiles or dirs...>
   sonic --version
   sonic --author
   sonic --license
@@ -33,8 +46,33 @@ Usage:
 
 Options:
   --debug        Enable debug mode
+  --json-compact Write --debug JSON dumps without indentation
   --release      Enable release mode
   --no-opt       Disable optimization
+  -O2, -O3       Optimization level (default -O2)
+  -Ofast         -O3 plus fast-math
+  --time-passes  Report time spent in each LLVM pass
+  --profile=dev  Build for compile latency: -O0, FastISel, all cores, and
+                 report how long the build took
+  -g             Emit debug info: line tables, parameters and locals
+  -gline-tables-only
+                 Emit line tables only, cheap enough for optimized builds
+  --emit=<kinds> Artifacts to write: obj, asm, bc, ll (default obj)
+  -j <N>         Generate and compile modules on N threads (0 = all cores)
+  --no-cache     Do not reuse or store compiled objects and JIT machine code
+  --cache-stats  Report cache hits and misses
+  --hot          With run: reload changed functions without restarting
+  --lto=thin     Optimize across modules with ThinLTO at link time
+  --lto=full     Link the code reachable from main into one module and
+                 optimize it as a whole
+  --target <t>   Target triple; a comma separated list builds each one into
+                 build/<triple>/ from a single frontend pass
+  --cpu=<name>   CPU to generate code for, `native` for this machine
+  --features=<f> Extra target features, e.g. +avx2,-avx512f
+  --profile-generate[=<dir>]
+                 Instrument the program to write .profraw files (build/profile)
+  --profile-use=<path>
+                 Optimize with a .profdata file, or merge .profraw files first
 )";
 }
 
@@ -50,6 +88,11 @@ static void print_license() {
   std::cout << cfg::APP_LICENSE << "\n";
 }
 
+// an explicit -O / --no-opt; `sonic run` otherwise favours startup time
+static bool opt_level_set = false;
+// an explicit -j, the dev profile otherwise uses every core
+static bool jobs_set = false;
+
 void check_arguments(int argc, char* argv[]) {
   if (argc < 2) {
     print_help();
@@ -91,23 +134,53 @@ void check_arguments(int argc, char* argv[]) {
       sonic::startup::generate_project_folder(argv[i + 1]);
       std::exit(0);
     }
+    // ===== PROFILES =====
+    else if (arg == "merge-profiles") {
+      if (i + 2 >= argc) {
+        std::cerr << "Missing output or input profiles\n";
+        std::exit(1);
+      }
+
+      std::vector<std::string> inputs(argv + i + 2, argv + argc);
+      std::exit(sonic::backend::merge_profiles(inputs, argv[i + 1]) ? 0 : 1);
+    }
     // ===== BUILD FLAGS =====
     else if (arg == "compile") {
       cfg::is_compiled = true;
       sonic::config::project_path = "src/main.sn";
       continue;
     }
+    else if (arg == "run") {
+      sonic::config::project_path = "src/main.sn";
+      continue;
+    }
     else if (arg == "--debug") {
       cfg::runtime_debug = true;   // override compile-time
       continue;
     }
+    else if (arg == "--json-compact") {
+      cfg::json_compact = true;
+      continue;
+    }
     else if (arg == "--target") {
       if (i + 1 >= argc) {
         std::cerr << "Missing target triple\n";
         std::exit(0);
       }
 
-      cfg::target_platform = argv[i + 1];
+      // a comma separated list builds every triple from one frontend pass
+      cfg::target_platforms.clear();
+      std::stringstream triples(argv[i + 1]);
+      std::string triple;
+      while (std::getline(triples, triple, ',')) {
+        if (!triple.empty()) cfg::target_platforms.push_back(triple);
+      }
+      if (cfg::target_platforms.empty()) {
+        std::cerr << "Missing target triple\n";
+        std::exit(0);
+      }
+
+      cfg::target_platform = cfg::target_platforms.front();
       i++;
       continue;
     }
@@ -118,11 +191,115 @@ void check_arguments(int argc, char* argv[]) {
     else if (arg == "--no-opt") {
       cfg::runtime_optimized = false;
       cfg::optimizer_level = sonic::config::OptLevel::NO;
+      opt_level_set = true;
+      continue;
+    }
+    else if (arg == "--no-cache") {
+      cfg::jit_cache = false;
+      cfg::object_cache = false;
+      continue;
+    }
+    else if (arg == "--cache-stats") {
+      cfg::cache_stats = true;
+      continue;
+    }
+    else if (arg == "-g") {
+      cfg::debug_info = cfg::DEBUG_FULL;
+      continue;
+    }
+    else if (arg == "-gline-tables-only") {
+      cfg::debug_info = cfg::DEBUG_LINE_TABLES;
+      continue;
+    }
+    else if (arg.rfind("--cpu=", 0) == 0) {
+      cfg::target_cpu = arg.substr(6);
+      continue;
+    }
+    else if (arg.rfind("--features=", 0) == 0) {
+      cfg::target_features = arg.substr(11);
+      continue;
+    }
+    else if (arg == "--profile-generate" || arg.rfind("--profile-generate=", 0) == 0) {
+      cfg::profile_generate = true;
+      if (arg.size() > 18) cfg::profile_dir = sonic::io::resolvePath(arg.substr(19));
+      continue;
+    }
+    else if (arg.rfind("--profile-use=", 0) == 0) {
+      cfg::profile_use = sonic::io::resolvePath(arg.substr(14));
+      continue;
+    }
+    else if (arg.rfind("--lto=", 0) == 0) {
+      std::string mode = arg.substr(6);
+      if (mode == "thin") cfg::lto_mode = cfg::LTO_THIN;
+      else if (mode == "full") cfg::lto_mode = cfg::LTO_FULL;
+      else if (mode == "none") cfg::lto_mode = cfg::LTO_NONE;
+      else {
+        std::cerr << "\033[31m(error)\033[0m " << "unknown lto mode '" << mode << "'\n";
+        std::exit(0);
+      }
+      continue;
+    }
+    else if (arg == "--hot") {
+      cfg::hot_reload = true;
+      continue;
+    }
+    else if (arg.rfind("--profile=", 0) == 0) {
+      std::string profile = arg.substr(10);
+      if (profile == "dev") cfg::build_profile = cfg::PROFILE_DEV;
+      else if (profile == "default") cfg::build_profile = cfg::PROFILE_DEFAULT;
+      else {
+        std::cerr << "\033[31m(error)\033[0m " << "unknown profile '" << profile << "'\n";
+        std::exit(0);
+      }
+      continue;
+    }
+    else if (arg == "--time-passes") {
+      cfg::time_passes = true;
+      continue;
+    }
+    else if (arg.rfind("--emit=", 0) == 0) {
+      cfg::emit_kinds = 0;
+      std::stringstream kinds(arg.substr(7));
+      std::string kind;
+      while (std::getline(kinds, kind, ',')) {
+        if (kind == "obj") cfg::emit_kinds |= cfg::EMIT_OBJ;
+        else if (kind == "asm") cfg::emit_kinds |= cfg::EMIT_ASM;
+        else if (kind == "bc") cfg::emit_kinds |= cfg::EMIT_BC;
+        else if (kind == "ll") cfg::emit_kinds |= cfg::EMIT_LL;
+        else {
+          std::cerr << "\033[31m(error)\033[0m " << "unknown emit kind '" << kind << "'\n";
+          std::exit(0);
+        }
+      }
+      continue;
+    }
+    else if (arg.rfind("-j", 0) == 0) {
+      std::string jobs = arg.substr(2);
+      if (jobs.empty()) {
+        if (i + 1 >= argc) {
+          std::cerr << "Missing job count\n";
+          std::exit(0);
+        }
+        jobs = argv[++i];
+      }
+
+      if (jobs.empty() || jobs.find_first_not_of("0123456789") != std::string::npos) {
+        std::cerr << "\033[31m(error)\033[0m " << "invalid job count '" << jobs << "'\n";
+        std::exit(0);
+      }
+
+      cfg::codegen_jobs = std::stoul(jobs);
+      if (cfg::codegen_jobs == 0) cfg::codegen_jobs = std::max(1u, std::thread::hardware_concurrency());
+      jobs_set = true;
+      continue;
+    }
+    else if (arg == "-O2" || arg == "-O3" || arg == "-Ofast") {
+      if (arg == "-O2") cfg::optimizer_level = sonic::config::OptLevel::O2;
+      else if (arg == "-O3") cfg::optimizer_level = sonic::config::OptLevel::O3;
+      else cfg::optimizer_level = sonic::config::OptLevel::OFAST;
+      opt_level_set = true;
       continue;
     }
-    else if (arg == "-O2") cfg::optimizer_level = sonic::config::OptLevel::O2;
-    else if (arg == "-O3") cfg::optimizer_level = sonic::config::OptLevel::O3;
-    else if (arg == "-Ofast") cfg::optimizer_level = sonic::config::OptLevel::OFAST;
     else {
        if (i <= 2 && sonic::io::is_exists(arg) && sonic::io::is_file(arg)) {
         sonic::config::project_path = arg;
@@ -144,23 +321,84 @@ void check_arguments(int argc, char* argv[]) {
       }
     }
   } 
+
+  // explicit flags win over the profile
+  if (cfg::build_profile == cfg::PROFILE_DEV) {
+    if (!opt_level_set) {
+      cfg::runtime_optimized = false;
+      cfg::optimizer_level = sonic::config::OptLevel::NO;
+    }
+    if (!jobs_set) cfg::codegen_jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
 }
 
 using namespace sonic::io;
 
 void compile_project();
-void run_project();
+int run_project();
+static bool reanalyze_project(Symbol*& symbols, std::vector<ast::Program*>& programs);
+
+static double elapsed_ms(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// <build dir>/<name>, named after the project folder unless an output
+// name is set
+static std::string executable_path(const sonic::backend::BuildTarget& target) {
+  std::string name = cfg::output_name;
+  if (name.empty()) name = std::filesystem::path(cfg::project_root).parent_path().filename().string();
+  if (target.key.triple.find("windows") != std::string::npos) name += ".exe";
+  return target.dir + "/" + name;
+}
+
+struct TargetTimes {
+  double backend = 0;
+  double link = 0;
+};
+
+// everything after semantic analysis for one target; the AST and symbols
+// are only read, so several targets can run at once
+static bool build_target(Symbol* symbols, const sonic::backend::BuildTarget& target, sonic::backend::ObjectStore* store, const std::string& interface, unsigned jobs, TargetTimes& times) {
+  auto started = std::chrono::steady_clock::now();
+  std::vector<std::string> objects;
+  bool generated = sonic::backend::generate_modules(symbols, astListManager, target, store, interface, jobs, objects);
+  times.backend = elapsed_ms(started);
+  if (!generated) return false;
+
+  started = std::chrono::steady_clock::now();
+  if (cfg::emit_kinds & cfg::EMIT_OBJ) {
+    if (cfg::lto_mode == cfg::LTO_THIN) {
+      std::vector<std::string> linked;
+      if (!sonic::backend::thin_link(objects, target, jobs, linked)) return false;
+      objects = std::move(linked);
+    } else if (cfg::lto_mode == cfg::LTO_FULL) {
+      std::vector<std::string> linked;
+      if (!sonic::backend::full_link(objects, target, linked)) return false;
+      objects = std::move(linked);
+    }
+
+    if (!sonic::backend::link_executable(objects, executable_path(target), target.key.triple)) return false;
+  }
+  times.link = elapsed_ms(started);
+  return true;
+}
 
 int main(int argc, char* argv[]) {
   check_arguments(argc, argv);
+  // process wide, so set before any codegen thread builds a pipeline
+  llvm::TimePassesIsEnabled = cfg::time_passes;
 
+  int status = 0;
   if (cfg::is_compiled) compile_project();
-  else if (!cfg::is_compiled && !cfg::project_path.empty()) run_project();
+  else if (!cfg::is_compiled && !cfg::project_path.empty()) status = run_project();
 
-  return 0;
+  if (cfg::time_passes) llvm::reportAndResetTimings(&llvm::errs());
+
+  return status;
 }
 
 void compile_project() {
+  auto started = std::chrono::steady_clock::now();
   std::string f = sonic::config::project_path;
 
   std::string content(read_file(f));
@@ -189,22 +427,84 @@ void compile_project() {
 
   diag.flush();
 
-  for (auto& ast_prog : astListManager) {
-    sonic::backend::SonicCodegen codegen(symbols);
-    codegen.generate(ast_prog);
+  if (cfg::profile_generate && cfg::profile_dir.empty()) cfg::profile_dir = cfg::project_build + "/profile";
+  if (!cfg::profile_use.empty()) {
+    cfg::profile_use = sonic::backend::resolve_profile(cfg::profile_use);
+    if (cfg::profile_use.empty()) std::exit(1);
+  }
+
+  // one backend pipeline per target, in parallel, sharing the cores
+  auto targets = sonic::backend::build_targets();
+  unsigned jobs = std::max<unsigned>(1, cfg::codegen_jobs / targets.size());
+
+  std::vector<std::unique_ptr<sonic::backend::ObjectStore>> stores(targets.size());
+  if (cfg::object_cache) {
+    for (size_t t = 0; t < targets.size(); t++) {
+      stores[t] = std::make_unique<sonic::backend::ObjectStore>(targets[t].dir + "/cache/objects", targets[t].key, cfg::object_cache_limit);
+    }
+  }
+
+  // function bodies of a cached module are only decoded and analyzed when
+  // some target has to compile it again; this happens before the target
+  // threads start, codegen never writes to the AST
+  std::string interface = sonic::backend::ObjectStore::interfaceOf(symbols);
+  for (auto pg : astListManager) {
+    if (!pg->hasLazyBodies()) continue;
+
+    bool reused = sonic::backend::objects_cacheable();
+    for (auto& store : stores) {
+      reused = reused && store && store->contains(store->keyForSource(*pg, interface));
+    }
+    if (!reused) analyzer.analyze_bodies(pg);
+  }
+  diag.flush();
+
+  double frontend = elapsed_ms(started);
+
+  std::vector<TargetTimes> times(targets.size());
+  std::vector<char> built(targets.size(), false);
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < targets.size(); t++) {
+    threads.emplace_back([&, t] { built[t] = build_target(symbols, targets[t], stores[t].get(), interface, jobs, times[t]); });
+  }
+  built[0] = build_target(symbols, targets[0], stores[0].get(), interface, jobs, times[0]);
+  for (auto& thread : threads) thread.join();
+
+  if (std::find(built.begin(), built.end(), false) != built.end()) std::exit(1);
+
+  if (cfg::build_profile == cfg::PROFILE_DEV) {
+    std::cerr << "compiled " << astListManager.size() << " module(s) in " << static_cast<long>(elapsed_ms(started)) << " ms"
+              << " (frontend " << static_cast<long>(frontend) << " ms";
+    for (size_t t = 0; t < targets.size(); t++) {
+      if (targets.size() > 1) std::cerr << ", " << targets[t].key.triple << ":";
+      std::cerr << " backend " << static_cast<long>(times[t].backend) << " ms, link " << static_cast<long>(times[t].link) << " ms";
+    }
+    std::cerr << ")\n";
   }
 }
 
-void run_project() {
+int run_project() {
   std::string f = sonic::config::project_path;
 
   std::string content(read_file(f));
 
   if (content.empty()) {
     std::cerr << "\033[31m(error)\033[0m file '" << f << "' is empty or cannot be read.\n";
-    return;
+    return 1;
+  }
+
+  if (cfg::profile_generate) {
+    std::cerr << "\033[31m(error)\033[0m --profile-generate needs `sonic compile`, the JIT has no profile runtime\n";
+    return 1;
+  }
+
+  if (cfg::target_platforms.size() > 1) {
+    std::cerr << "\033[31m(error)\033[0m `sonic run` takes a single --target\n";
+    return 1;
   }
 
+  if (!opt_level_set) cfg::optimizer_level = sonic::config::OptLevel::NO;
+
   sonic::startup::setProjectRoot(f);
 
   DiagnosticEngine diag;
@@ -214,7 +514,7 @@ void run_project() {
   parser.diag = &diag;
   auto program = parser.parse();
 
-  cfg::project_build = sonic::io::resolvePath(sonic::io::getFullPath(cfg::project_root + "/build"));
+  cfg::project_build = sonic::io::resolvePath(sonic::io::getFullPath(cfg::project_root + "/../build"));
   auto symbols = new Symbol();
 
   SemanticAnalyzer analyzer(symbols);
@@ -222,10 +522,48 @@ void run_project() {
   analyzer.diag = &diag;
   analyzer.analyze(program.get());
 
+  // the JIT lowers every module
+  for (auto pg : astListManager) analyzer.analyze_bodies(pg);
   diag.flush();
 
-  for (auto& ast_prog : astListManager) {
-    sonic::backend::SonicCodegen codegen(symbols);
-    codegen.generate(ast_prog);
+  if (cfg::hot_reload) return sonic::backend::run_hot(symbols, astListManager, reanalyze_project);
+  return sonic::backend::run_jit(symbols, astListManager);
+}
+
+// frontend pass of a --hot reload; errors are printed and the running
+// program is kept
+static bool reanalyze_project(Symbol*& symbols, std::vector<ast::Program*>& programs) {
+  std::string f = sonic::config::project_path;
+
+  std::string content(read_file(f));
+  if (content.empty()) return false;
+
+  astListManager.clear();
+
+  DiagnosticEngine diag;
+  sonic::frontend::Lexer lexer(content, getFullPath(f));
+  lexer.diag = &diag;
+  sonic::frontend::Parser parser(getFullPath(f), &lexer);
+  parser.diag = &diag;
+  auto program = parser.parse();
+
+  auto root = new Symbol();
+  if (program && !diag.has_errors()) {
+    SemanticAnalyzer analyzer(root);
+    analyzer.filepath = sonic::io::getPathWithoutFile(f);
+    analyzer.diag = &diag;
+    analyzer.analyze(program.get());
+    for (auto pg : astListManager) analyzer.analyze_bodies(pg);
   }
+
+  diag.print();
+  if (!program || diag.has_errors()) {
+    astListManager.clear();
+    return false;
+  }
+
+  keep_module(std::move(program));
+  symbols = root;
+  programs = astListManager;
+  return true;
 }